@@ -0,0 +1,229 @@
+#include <algorithm>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "candidates.h"
+
+using namespace std;
+
+// words per filter block, one AVX2 byte compare
+static const size_t BLOCK = 32;
+
+// What a guess and its feedback say about the answer
+struct Constraints {
+  uint8_t letter[WORD_LENGTH];
+  bool green[WORD_LENGTH];   // letter[i] is at i, otherwise it isn't
+  uint32_t present;          // letters the answer has at least once
+  uint32_t absent;           // letters the answer doesn't have
+  int num_counts;            // letters presence alone can't settle, and their count
+  uint8_t count_letter[WORD_LENGTH];
+  uint8_t count[WORD_LENGTH];
+  bool exact[WORD_LENGTH];   // exactly count of them, else at least count
+  bool impossible;           // no word scores this pattern
+};
+
+// For a letter the guess has several of, greens and yellows together are
+// min(guess count, answer count); a gray among them pins the answer count.
+// Yellows go to the leftmost non-green copies, so a pattern with a gray
+// copy left of a yellow one can't come from score_guess().
+static Constraints compile(PackedWord guess, int pattern) {
+  Constraints c;
+  c.present = c.absent = 0;
+  c.num_counts = 0;
+  c.impossible = false;
+  int digit[WORD_LENGTH];
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    c.letter[i] = (uint8_t)word_letter(guess, i);
+    digit[i] = pattern % 3;
+    pattern /= 3;
+    c.green[i] = digit[i] == FEEDBACK_GREEN;
+  }
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    int l = c.letter[i];
+    bool first = true;
+    for (int j = 0; j < i; ++j) {
+      first = first && c.letter[j] != l;
+    }
+    if (!first) {
+      continue;
+    }
+    int hits = 0;
+    bool gray = false;
+    for (int j = i; j < WORD_LENGTH; ++j) {
+      if (c.letter[j] != l) {
+        continue;
+      }
+      if (digit[j] == FEEDBACK_GRAY) {
+        gray = true;
+      } else {
+        c.impossible = c.impossible || (gray && digit[j] == FEEDBACK_YELLOW);
+        ++hits;
+      }
+    }
+    if (hits == 0) {
+      c.absent |= 1u << l;
+      continue;
+    }
+    c.present |= 1u << l;
+    if (gray || hits > 1) {
+      c.count_letter[c.num_counts] = (uint8_t)l;
+      c.count[c.num_counts] = (uint8_t)hits;
+      c.exact[c.num_counts] = gray;
+      ++c.num_counts;
+    }
+  }
+  return c;
+}
+
+// bit k set when word b + k passes
+static uint32_t match_scalar(const Constraints& c, const uint8_t* const* planes, const uint32_t* masks, size_t b) {
+  uint32_t keep = 0;
+  for (size_t k = 0; k < BLOCK; ++k) {
+    size_t w = b + k;
+    bool ok = (masks[w] & c.absent) == 0 && (masks[w] & c.present) == c.present;
+    for (int i = 0; i < WORD_LENGTH && ok; ++i) {
+      ok = (planes[i][w] == c.letter[i]) == c.green[i];
+    }
+    for (int n = 0; n < c.num_counts && ok; ++n) {
+      int count = 0;
+      for (int i = 0; i < WORD_LENGTH; ++i) {
+        count += planes[i][w] == c.count_letter[n];
+      }
+      ok = c.exact[n] ? count == c.count[n] : count >= c.count[n];
+    }
+    keep |= (uint32_t)ok << k;
+  }
+  return keep;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static uint32_t match_avx2(const Constraints& c, const uint8_t* const* planes, const uint32_t* masks, size_t b) {
+  __m256i ok = _mm256_set1_epi8(-1);
+  __m256i p[WORD_LENGTH];
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    p[i] = _mm256_loadu_si256((const __m256i*)(planes[i] + b));
+    __m256i eq = _mm256_cmpeq_epi8(p[i], _mm256_set1_epi8((char)c.letter[i]));
+    ok = c.green[i] ? _mm256_and_si256(ok, eq) : _mm256_andnot_si256(eq, ok);
+  }
+
+  // the masks are 32-bit lanes, narrowed to one byte per word
+  __m256i absent = _mm256_set1_epi32((int)c.absent);
+  __m256i present = _mm256_set1_epi32((int)c.present);
+  __m256i zero = _mm256_setzero_si256();
+  __m256i m[4];
+  for (int q = 0; q < 4; ++q) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(masks + b + 8 * q));
+    m[q] = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(v, absent), zero),
+                            _mm256_cmpeq_epi32(_mm256_and_si256(v, present), present));
+  }
+  __m256i bytes = _mm256_packs_epi16(_mm256_packs_epi32(m[0], m[1]), _mm256_packs_epi32(m[2], m[3]));
+  bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+  ok = _mm256_and_si256(ok, bytes);
+
+  // compares are -1, so the sum is minus the count
+  for (int n = 0; n < c.num_counts; ++n) {
+    __m256i letter = _mm256_set1_epi8((char)c.count_letter[n]);
+    __m256i count = zero;
+    for (int i = 0; i < WORD_LENGTH; ++i) {
+      count = _mm256_add_epi8(count, _mm256_cmpeq_epi8(p[i], letter));
+    }
+    __m256i pass = c.exact[n] ? _mm256_cmpeq_epi8(count, _mm256_set1_epi8(-(char)c.count[n]))
+                              : _mm256_cmpgt_epi8(_mm256_set1_epi8(1 - (char)c.count[n]), count);
+    ok = _mm256_and_si256(ok, pass);
+  }
+  return (uint32_t)_mm256_movemask_epi8(ok);
+}
+#endif
+
+static bool avx2_supported() {
+#if defined(__x86_64__)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+CandidateSet::CandidateSet() : m_avx2(avx2_supported()) {}
+
+void CandidateSet::set_simd(bool enable) {
+  m_avx2 = enable && avx2_supported();
+}
+
+void CandidateSet::reserve(size_t n) {
+  size_t padded = (n + BLOCK - 1) / BLOCK * BLOCK;
+  if (m_masks.size() < padded) {
+    for (int i = 0; i < WORD_LENGTH; ++i) {
+      m_planes[i].resize(padded);
+    }
+    m_masks.resize(padded);
+  }
+}
+
+void CandidateSet::assign(const PackedWord* words, size_t n) {
+  reserve(n);
+  m_ids.resize(n);
+  for (size_t w = 0; w < n; ++w) {
+    uint32_t mask = 0;
+    for (int i = 0; i < WORD_LENGTH; ++i) {
+      int l = word_letter(words[w], i);
+      m_planes[i][w] = (uint8_t)l;
+      mask |= 1u << l;
+    }
+    m_masks[w] = mask;
+    m_ids[w] = (uint32_t)w;
+  }
+}
+
+PackedWord CandidateSet::word(size_t i) const {
+  PackedWord w = 0;
+  for (int j = 0; j < WORD_LENGTH; ++j) {
+    w |= (PackedWord)m_planes[j][i] << (5 * j);
+  }
+  return w;
+}
+
+size_t CandidateSet::filter_from(const CandidateSet& from, PackedWord guess, int pattern) {
+  Constraints c = compile(guess, pattern);
+  size_t n = from.size();
+  if (c.impossible) {
+    m_ids.clear();
+    return 0;
+  }
+  reserve(n);
+  if (m_ids.size() < n) {
+    m_ids.resize(n);
+  }
+  const uint8_t* planes[WORD_LENGTH];
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    planes[i] = from.m_planes[i].data();
+  }
+  uint32_t (*match)(const Constraints&, const uint8_t* const*, const uint32_t*, size_t) = match_scalar;
+#if defined(__x86_64__)
+  if (m_avx2) {
+    match = match_avx2;
+  }
+#endif
+
+  // survivors only move down, so filtering in place is safe: a block is
+  // read in full before any of it is overwritten
+  size_t kept = 0;
+  for (size_t b = 0; b < n; b += BLOCK) {
+    uint32_t keep = match(c, planes, from.m_masks.data(), b);
+    if (n - b < BLOCK) {
+      keep &= (1u << (n - b)) - 1;
+    }
+    while (keep) {
+      size_t w = b + __builtin_ctz(keep);
+      keep &= keep - 1;
+      for (int i = 0; i < WORD_LENGTH; ++i) {
+        m_planes[i][kept] = planes[i][w];
+      }
+      m_masks[kept] = from.m_masks[w];
+      m_ids[kept] = from.m_ids[w];
+      ++kept;
+    }
+  }
+  m_ids.resize(kept);
+  return kept;
+}
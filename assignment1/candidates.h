@@ -0,0 +1,45 @@
+#ifndef __CANDIDATES_H__
+#define __CANDIDATES_H__
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "feedback.h"
+
+// Words still possible after some guesses, stored as structure of arrays:
+// one byte plane per letter position and a 26-bit mask of the letters in
+// each word, padded to whole blocks of 32 words. filter() turns a guess and
+// its feedback into position, presence and letter count constraints and
+// checks them against 32 words per instruction with AVX2 (when the CPU has
+// it), then compacts the survivors in place.
+//
+// A word survives exactly when score_guess(guess, word) == pattern.
+class CandidateSet {
+public:
+  CandidateSet();
+
+  // every word, ids are positions in words
+  void assign(const PackedWord* words, size_t n);
+  // keeps the words consistent with pattern for guess, returns how many
+  size_t filter(PackedWord guess, int pattern) { return filter_from(*this, guess, pattern); }
+  // this becomes the words of from consistent with pattern for guess
+  size_t filter_from(const CandidateSet& from, PackedWord guess, int pattern);
+
+  size_t size() const { return m_ids.size(); }
+  // ids of the words left, in the order they were assigned
+  const std::vector<uint32_t>& ids() const { return m_ids; }
+  PackedWord word(size_t i) const;
+
+  // scalar code even where AVX2 is available, for benchmarks
+  void set_simd(bool enable);
+  bool simd() const { return m_avx2; }
+
+private:
+  void reserve(size_t n);
+
+  std::vector<uint8_t> m_planes[WORD_LENGTH];
+  std::vector<uint32_t> m_masks;
+  std::vector<uint32_t> m_ids;
+  bool m_avx2;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "feedback.h"
+
+using namespace std;
+
+static const char TABLE_MAGIC[4] = {'W', 'P', 'T', '1'};
+static const size_t TABLE_HEADER = 12;
+
+bool pack_word(const char* word, size_t len, PackedWord& packed) {
+  if (len != WORD_LENGTH) {
+    return false;
+  }
+  packed = 0;
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    char c = word[i] | 0x20; // lowercase
+    if (c < 'a' || c > 'z') {
+      return false;
+    }
+    packed |= (PackedWord)(c - 'a') << (5 * i);
+  }
+  return true;
+}
+
+string unpack_word(PackedWord word) {
+  string s(WORD_LENGTH, ' ');
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    s[i] = 'a' + word_letter(word, i);
+  }
+  return s;
+}
+
+int score_guess(PackedWord guess, PackedWord answer) {
+  static const int POW3[WORD_LENGTH] = {1, 3, 9, 27, 81};
+  uint8_t unmatched[32] = {0};
+  int pattern = 0;
+
+  // positions that differ are the only ones left to match
+  PackedWord diff = guess ^ answer;
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    if ((diff >> (5 * i)) & 31) {
+      ++unmatched[word_letter(answer, i)];
+    } else {
+      pattern += FEEDBACK_GREEN * POW3[i];
+    }
+  }
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    int g = word_letter(guess, i);
+    if (((diff >> (5 * i)) & 31) && unmatched[g]) {
+      --unmatched[g];
+      pattern += FEEDBACK_YELLOW * POW3[i];
+    }
+  }
+  return pattern;
+}
+
+PatternTable::PatternTable()
+  : m_num_guesses(0), m_num_answers(0), m_guesses(NULL), m_answers(NULL), m_patterns(NULL), m_map(NULL), m_map_size(0) {}
+
+PatternTable::~PatternTable() {
+  clear();
+}
+
+void PatternTable::clear() {
+  if (m_map) {
+    munmap(m_map, m_map_size);
+  }
+  m_map = NULL;
+  m_map_size = 0;
+  m_owned.clear();
+  m_num_guesses = m_num_answers = 0;
+  m_guesses = m_answers = NULL;
+  m_patterns = NULL;
+}
+
+void PatternTable::build(const vector<PackedWord>& guesses, const vector<PackedWord>& answers, unsigned threads) {
+  clear();
+  m_num_guesses = guesses.size();
+  m_num_answers = answers.size();
+
+  // same layout as the file so row() and lookup() don't care where it came from
+  size_t words = (m_num_guesses + m_num_answers) * sizeof(PackedWord);
+  m_owned.resize(words + m_num_guesses * m_num_answers);
+  PackedWord* w = reinterpret_cast<PackedWord*>(m_owned.data());
+  copy(guesses.begin(), guesses.end(), w);
+  copy(answers.begin(), answers.end(), w + m_num_guesses);
+  m_guesses = w;
+  m_answers = w + m_num_guesses;
+  uint8_t* patterns = m_owned.data() + words;
+  m_patterns = patterns;
+
+  if (threads == 0) {
+    threads = max(1u, thread::hardware_concurrency());
+  }
+  threads = (unsigned)min<size_t>(threads, max<size_t>(1, m_num_guesses));
+
+  // rows are independent; each thread takes a contiguous band of guesses
+  vector<thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    size_t begin = m_num_guesses * t / threads, end = m_num_guesses * (t + 1) / threads;
+    workers.push_back(thread([=]() {
+      for (size_t g = begin; g < end; ++g) {
+        uint8_t* row = patterns + g * m_num_answers;
+        for (size_t a = 0; a < m_num_answers; ++a) {
+          row[a] = (uint8_t)score_guess(m_guesses[g], m_answers[a]);
+        }
+      }
+    }));
+  }
+  for (size_t t = 0; t < workers.size(); ++t) {
+    workers[t].join();
+  }
+}
+
+bool PatternTable::save(const string& path) const {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+  uint32_t counts[2] = {(uint32_t)m_num_guesses, (uint32_t)m_num_answers};
+  size_t cells = m_num_guesses * m_num_answers;
+  bool ok = fwrite(TABLE_MAGIC, 1, 4, f) == 4 &&
+            fwrite(counts, sizeof(uint32_t), 2, f) == 2 &&
+            fwrite(m_guesses, sizeof(PackedWord), m_num_guesses, f) == m_num_guesses &&
+            fwrite(m_answers, sizeof(PackedWord), m_num_answers, f) == m_num_answers &&
+            fwrite(m_patterns, 1, cells, f) == cells;
+  return fclose(f) == 0 && ok;
+}
+
+bool PatternTable::load(const string& path) {
+  clear();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < TABLE_HEADER) {
+    close(fd);
+    return false;
+  }
+  void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    return false;
+  }
+  m_map = p;
+  m_map_size = st.st_size;
+
+  const char* base = static_cast<const char*>(p);
+  uint32_t counts[2];
+  memcpy(counts, base + 4, sizeof(counts));
+  size_t words = ((size_t)counts[0] + counts[1]) * sizeof(PackedWord);
+  if (memcmp(base, TABLE_MAGIC, 4) != 0 ||
+      m_map_size != TABLE_HEADER + words + (size_t)counts[0] * counts[1]) {
+    clear();
+    return false;
+  }
+  m_num_guesses = counts[0];
+  m_num_answers = counts[1];
+  m_guesses = reinterpret_cast<const PackedWord*>(base + TABLE_HEADER);
+  m_answers = m_guesses + m_num_guesses;
+  m_patterns = reinterpret_cast<const uint8_t*>(base + TABLE_HEADER + words);
+  return true;
+}
@@ -0,0 +1,83 @@
+#ifndef __FEEDBACK_H__
+#define __FEEDBACK_H__
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wordle feedback on packed words.
+//
+// A word is packed into an integer, 5 bits per letter ('a' = 0), letter i
+// in bits [5i, 5i + 5). The feedback for a guess is a base-3 number with
+// one digit per letter (0 gray, 1 yellow, 2 green), letter i weighing 3^i,
+// so every pattern fits in a byte.
+
+typedef uint32_t PackedWord;
+
+const int WORD_LENGTH = 5;
+const int NUM_PATTERNS = 243; // 3^5
+const int ALL_GREEN = NUM_PATTERNS - 1;
+
+enum Feedback { FEEDBACK_GRAY = 0, FEEDBACK_YELLOW = 1, FEEDBACK_GREEN = 2 };
+
+// false unless word is exactly 5 letters (either case)
+bool pack_word(const char* word, size_t len, PackedWord& packed);
+inline bool pack_word(const std::string& word, PackedWord& packed) {
+  return pack_word(word.data(), word.length(), packed);
+}
+std::string unpack_word(PackedWord word);
+
+inline int word_letter(PackedWord word, int i) {
+  return (word >> (5 * i)) & 31;
+}
+
+// Greens are taken first; then, left to right, a letter is yellow while the
+// answer still has unmatched copies of it, so "speed" against "abide"
+// gives one yellow e, not two.
+int score_guess(PackedWord guess, PackedWord answer);
+
+inline int pattern_digit(int pattern, int i) {
+  static const int POW3[WORD_LENGTH] = {1, 3, 9, 27, 81};
+  return pattern / POW3[i] % 3;
+}
+
+// Guess x answer pattern matrix, built in memory or mapped from a file
+// written by save():
+//
+//   "WPT1", guess count and answer count as uint32
+//   the guesses, then the answers, as uint32 packed words
+//   guesses * answers pattern bytes, one row per guess
+//
+// All integers are little-endian.
+class PatternTable {
+public:
+  PatternTable();
+  ~PatternTable();
+
+  // threads = 0 uses every core
+  void build(const std::vector<PackedWord>& guesses, const std::vector<PackedWord>& answers, unsigned threads = 0);
+  bool save(const std::string& path) const;
+  bool load(const std::string& path); // maps the file, nothing is copied
+
+  size_t num_guesses() const { return m_num_guesses; }
+  size_t num_answers() const { return m_num_answers; }
+  const PackedWord* guesses() const { return m_guesses; }
+  const PackedWord* answers() const { return m_answers; }
+  const uint8_t* row(size_t guess) const { return m_patterns + guess * m_num_answers; }
+  int lookup(size_t guess, size_t answer) const { return m_patterns[guess * m_num_answers + answer]; }
+
+private:
+  PatternTable(const PatternTable&);
+  PatternTable& operator=(const PatternTable&);
+  void clear();
+
+  size_t m_num_guesses, m_num_answers;
+  const PackedWord* m_guesses;
+  const PackedWord* m_answers;
+  const uint8_t* m_patterns;
+  std::vector<uint8_t> m_owned; // backing store after build()
+  void* m_map; // backing store after load()
+  size_t m_map_size;
+};
+
+#endif
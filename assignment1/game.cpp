@@ -0,0 +1,40 @@
+#include "game.h"
+
+using namespace std;
+
+SessionTable::SessionTable(size_t capacity) : m_slots(capacity), m_generation(capacity, 0) {
+  m_free.reserve(capacity);
+  for (size_t i = capacity; i-- > 0; ) {
+    m_free.push_back((uint32_t)i);
+  }
+}
+
+bool SessionTable::create(PackedWord target, uint64_t& id) {
+  if (m_free.empty()) {
+    return false;
+  }
+  uint32_t slot = m_free.back();
+  m_free.pop_back();
+  ++m_generation[slot];
+  m_slots[slot].start(target);
+  id = (uint64_t)m_generation[slot] << 32 | slot;
+  return true;
+}
+
+GameSession* SessionTable::find(uint64_t id) {
+  uint32_t slot = (uint32_t)id, gen = (uint32_t)(id >> 32);
+  if (slot >= m_slots.size() || m_generation[slot] != gen || !(gen & 1)) {
+    return NULL;
+  }
+  return &m_slots[slot];
+}
+
+bool SessionTable::close(uint64_t id) {
+  if (!find(id)) {
+    return false;
+  }
+  uint32_t slot = (uint32_t)id;
+  ++m_generation[slot];
+  m_free.push_back(slot);
+  return true;
+}
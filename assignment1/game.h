@@ -0,0 +1,61 @@
+#ifndef __GAME_H__
+#define __GAME_H__
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "feedback.h"
+
+const int MAX_ATTEMPTS = 6;
+
+enum GameState { GAME_PLAYING, GAME_WON, GAME_LOST };
+
+// One game: the target and every guess so far with its feedback pattern,
+// in a fixed 36 byte block.
+struct GameSession {
+  PackedWord target;
+  PackedWord guesses[MAX_ATTEMPTS];
+  uint8_t patterns[MAX_ATTEMPTS];
+  uint8_t attempts;
+  uint8_t state;
+
+  void start(PackedWord word) {
+    target = word;
+    attempts = 0;
+    state = GAME_PLAYING;
+  }
+  // scores a (valid) guess and returns its pattern; the game must be in play
+  int guess(PackedWord word) {
+    int pattern = score_guess(word, target);
+    guesses[attempts] = word;
+    patterns[attempts] = (uint8_t)pattern;
+    ++attempts;
+    if (pattern == ALL_GREEN) {
+      state = GAME_WON;
+    } else if (attempts == MAX_ATTEMPTS) {
+      state = GAME_LOST;
+    }
+    return pattern;
+  }
+};
+
+// Fixed capacity pool of sessions addressed by id. An id is the slot in the
+// low 32 bits and the slot's generation above, so the id of a closed game
+// stays invalid after its slot is reused.
+class SessionTable {
+public:
+  SessionTable(size_t capacity);
+
+  // false when every slot is taken
+  bool create(PackedWord target, uint64_t& id);
+  GameSession* find(uint64_t id); // NULL if closed or never created
+  bool close(uint64_t id);
+  size_t active() const { return m_slots.size() - m_free.size(); }
+  size_t capacity() const { return m_slots.size(); }
+
+private:
+  std::vector<GameSession> m_slots;
+  std::vector<uint32_t> m_generation; // odd while the slot is in use
+  std::vector<uint32_t> m_free;
+};
+
+#endif
@@ -6,133 +6,339 @@
 #include <iomanip>
 #include <string>
 #include <algorithm>
-#include <numeric>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
-struct IrisRecord {
-  double sepal_length;
-  double sepal_width;
-  double petal_length;
-  double petal_width;
-  string species;
+// g++ -std=c++17 -O2 iris.cpp -pthread -o iris
+//
+//   ./iris [file] [threads]   summarize iris.txt, or file, in one pass
+//                             without keeping the records, split over
+//                             threads (every core by default)
+//   ./iris bench [copies] [threads]
+//                             time the scan on iris.txt repeated copies
+//                             times with 1, 2, 4... up to threads (every
+//                             core), against getline + stringstream
+
+// Min, max, mean and variance of a stream of values, updated one value at
+// a time (Welford's method, which doesn't lose the variance to
+// cancellation the way sum of squares / n - mean^2 does). Two of them
+// merge into the stats of both streams together.
+struct RunningStats {
+  size_t count;
+  double min, max, mean;
+  double m2; // sum of squared differences from the mean
+
+  RunningStats() : count(0), min(HUGE_VAL), max(-HUGE_VAL), mean(0), m2(0) {}
+
+  void add(double x) {
+    ++count;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+  }
+
+  void merge(const RunningStats &other) {
+    if (other.count == 0) {
+      return;
+    }
+    size_t n = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta * other.count / n;
+    m2 += other.m2 + delta * delta * ((double)count * other.count / n);
+    count = n;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+
+  // population standard deviation, like the table always showed
+  double stddev() const { return count ? sqrt(m2 / count) : 0; }
 };
 
+const int NUM_FEATURES = 4; // sepal length, sepal width, petal length, petal width
+
 struct SpeciesStats {
-  vector<double> sepal_length, sepal_width, petal_length, petal_width;
-};
+  RunningStats feature[NUM_FEATURES];
 
-// function to compute min, max, mean, and std. deviation
-void compute_stats(const vector<double> &data, double &min, double &max, double &mean, double &stddev) {
-  min = *min_element(data.begin(), data.end());
-  max = *max_element(data.begin(), data.end());
-  mean = accumulate(data.begin(), data.end(), 0.0) / data.size();
-  double sq_sum = inner_product(data.begin(), data.end(), data.begin(), 0.0);
-  stddev = sqrt(sq_sum / data.size() - mean * mean);
-}
+  void add(const double *values) {
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      feature[f].add(values[f]);
+    }
+  }
+  void merge(const SpeciesStats &other) {
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      feature[f].merge(other.feature[f]);
+    }
+  }
+};
 
 // print one row of stats for a species
-void print_row(const string &species_name, SpeciesStats &stats) {
-  double min, max, mean, stddev;
+void print_row(const string &species_name, const SpeciesStats &stats) {
   cout << "| " << setw(20) << left << species_name << " |";
 
   int w_size = 4;
+  for (int f = 0; f < NUM_FEATURES; ++f) {
+    const RunningStats &column = stats.feature[f];
+    if (column.count == 0) {
+      cout << setw(22) << "no data" << " |";
+      continue;
+    }
+    cout << setw(w_size) << fixed << setprecision(2) << column.min << ", "
+      << setw(w_size) << column.max << ", "
+      << setw(w_size) << column.mean << ", "
+      << setw(w_size) << column.stddev() << " |";
+  }
+  cout << endl;
+}
+
+const int NUM_SPECIES = 3;
+const char *const SPECIES_NAMES[NUM_SPECIES] = {"Iris-setosa", "Iris-versicolor", "Iris-virginica"};
 
-  // sepal_length
-  compute_stats(stats.sepal_length, min, max, mean, stddev);
-  cout << setw(w_size) << fixed << setprecision(2) << min << ", "
-    << setw(w_size) << max << ", "
-    << setw(w_size) << mean << ", "
-    << setw(w_size) << stddev << " |";
-
-  // sepal_width
-  compute_stats(stats.sepal_width, min, max, mean, stddev);
-  cout << setw(w_size) << fixed << setprecision(2) << min << ", "
-    << setw(w_size) << max << ", "
-    << setw(w_size) << mean << ", "
-    << setw(w_size) << stddev << " |";
-
-  // petal_length
-  compute_stats(stats.petal_length, min, max, mean, stddev);
-  cout << setw(w_size) << fixed << setprecision(2) << min << ", "
-    << setw(w_size) << max << ", "
-    << setw(w_size) << mean << ", "
-    << setw(w_size) << stddev << " |";
-
-  // petal_width
-  compute_stats(stats.petal_width, min, max, mean, stddev);
-  cout << setw(w_size) << fixed << setprecision(2) << min << ", "
-    << setw(w_size) << max << ", "
-    << setw(w_size) << mean << ", "
-    << setw(w_size) << stddev << " |" << endl;
+struct IrisSummary {
+  SpeciesStats species[NUM_SPECIES];
+
+  void merge(const IrisSummary &other) {
+    for (int s = 0; s < NUM_SPECIES; ++s) {
+      species[s].merge(other.species[s]);
+    }
+  }
+  size_t rows() const {
+    size_t n = 0;
+    for (int s = 0; s < NUM_SPECIES; ++s) {
+      n += species[s].feature[0].count;
+    }
+    return n;
+  }
+};
+
+// -1 for anything but the three species
+int species_index(const char *name, size_t len) {
+  for (int s = 0; s < NUM_SPECIES; ++s) {
+    if (len == strlen(SPECIES_NAMES[s]) && memcmp(name, SPECIES_NAMES[s], len) == 0) {
+      return s;
+    }
+  }
+  return -1;
 }
 
 // print the table of stats
-void print_table(SpeciesStats &setosa, SpeciesStats &versicolor, SpeciesStats &virginica) {
+void print_table(const IrisSummary &summary) {
   cout << setw(60) << "Iris Data" << endl;
   cout << string(120, '-') << endl;
   cout << "|      Species         | Sepal Length          | Sepal Width           | Petal Length          | Petal Width           |" << endl;
   cout << string(120, '-') << endl;
 
-  print_row("Iris-setosa", setosa);
-  cout << string(120, '-') << endl;
-  print_row("Iris-versicolor", versicolor);
-  cout << string(120, '-') << endl;
-  print_row("Iris-virginica", virginica);
-  cout << string(120, '-') << endl;
+  for (int s = 0; s < NUM_SPECIES; ++s) {
+    print_row(SPECIES_NAMES[s], summary.species[s]);
+    cout << string(120, '-') << endl;
+  }
+}
+
+// one line at a time through getline and stringstream
+void scan_stream(istream &in, IrisSummary &summary) {
+  string line;
+  while (getline(in, line)) {
+    stringstream ss(line);
+    string value;
+    double values[NUM_FEATURES];
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      getline(ss, value, ',');
+      values[f] = atof(value.c_str());
+    }
+    getline(ss, value, ',');
+    int s = species_index(value.data(), value.size());
+    if (s >= 0) {
+      summary.species[s].add(values);
+    }
+  }
+}
+
+// the lines starting in [begin, end), parsed in place; lines that don't
+// have four numbers are skipped
+void scan_range(const char *begin, const char *end, IrisSummary &summary) {
+  const char *p = begin;
+  while (p < end) {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    if (!eol) {
+      eol = end;
+    }
+    double values[NUM_FEATURES];
+    const char *q = p;
+    int f = 0;
+    for (; f < NUM_FEATURES; ++f) {
+      from_chars_result r = from_chars(q, eol, values[f]);
+      if (r.ec != errc() || r.ptr == eol || *r.ptr != ',') {
+        break;
+      }
+      q = r.ptr + 1;
+    }
+    if (f == NUM_FEATURES) {
+      const char *name_end = eol > q && eol[-1] == '\r' ? eol - 1 : eol;
+      int s = species_index(q, name_end - q);
+      if (s >= 0) {
+        summary.species[s].add(values);
+      }
+    }
+    p = eol + 1;
+  }
+}
+
+// start of the first line at or after pos
+const char *line_start(const char *data, size_t size, size_t pos) {
+  if (pos == 0 || pos >= size) {
+    return data + min(pos, size);
+  }
+  const char *nl = (const char *)memchr(data + pos - 1, '\n', size - pos + 1);
+  return nl ? nl + 1 : data + size;
+}
+
+// Maps the file and splits it into one byte range per thread, each moved
+// up to the next line start, so every line is scanned by exactly one
+// thread. The per-thread summaries are merged in file order.
+bool scan_file(const char *path, unsigned threads, IrisSummary &summary) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    return true;
+  }
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+  const char *data = (const char *)map;
+
+  threads = max(1u, threads);
+  vector<IrisSummary> partial(threads);
+  vector<thread> workers;
+  for (unsigned t = 1; t < threads; ++t) {
+    workers.push_back(thread([&, t]() {
+      scan_range(line_start(data, size, size * t / threads), line_start(data, size, size * (t + 1) / threads), partial[t]);
+    }));
+  }
+  scan_range(data, line_start(data, size, size / threads), partial[0]);
+  for (size_t t = 0; t < workers.size(); ++t) {
+    workers[t].join();
+  }
+  for (unsigned t = 0; t < threads; ++t) {
+    summary.merge(partial[t]);
+  }
+  munmap(map, size);
+  return true;
+}
+
+double seconds_since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
 }
 
-int main() {
+// largest relative difference between two summaries' means and deviations
+double max_difference(const IrisSummary &a, const IrisSummary &b) {
+  double worst = 0;
+  for (int s = 0; s < NUM_SPECIES; ++s) {
+    for (int f = 0; f < NUM_FEATURES; ++f) {
+      const RunningStats &x = a.species[s].feature[f];
+      const RunningStats &y = b.species[s].feature[f];
+      worst = max(worst, fabs(x.mean - y.mean) / max(fabs(x.mean), 1e-300));
+      worst = max(worst, fabs(x.stddev() - y.stddev()) / max(x.stddev(), 1e-300));
+      if (x.count != y.count || x.min != y.min || x.max != y.max) {
+        return HUGE_VAL;
+      }
+    }
+  }
+  return worst;
+}
+
+int bench(size_t copies, unsigned max_threads) {
   ifstream infile("iris.txt");
   if (!infile) {
     cerr << "Error opening iris.txt" << endl;
     return 1;
   }
+  stringstream contents;
+  contents << infile.rdbuf();
+  string text = contents.str();
+  if (!text.empty() && text.back() != '\n') {
+    text += '\n';
+  }
 
-  vector<IrisRecord> records;
-  string line;
-  while (getline(infile, line)) {
-    stringstream ss(line);
-    string value;
-    IrisRecord record;
-    getline(ss, value, ',');
-    record.sepal_length = atof(value.c_str());
-    getline(ss, value, ',');
-    record.sepal_width = atof(value.c_str());
-    getline(ss, value, ',');
-    record.petal_length = atof(value.c_str());
-    getline(ss, value, ',');
-    record.petal_width = atof(value.c_str());
-    getline(ss, value, ',');
-    record.species = value;
-    records.push_back(record);
+  const char *path = "iris_bench.txt";
+  FILE *out = fopen(path, "wb");
+  if (!out) {
+    cerr << "Error writing " << path << endl;
+    return 1;
+  }
+  for (size_t c = 0; c < copies; ++c) {
+    fwrite(text.data(), 1, text.size(), out);
   }
+  fclose(out);
+  double mb = (double)text.size() * copies / 1e6;
+  cout << path << ": iris.txt x " << copies << ", " << mb << " MB" << endl;
 
-  SpeciesStats setosa, versicolor, virginica;
+  // getline first, which also pulls the file into the page cache
+  IrisSummary reference;
+  auto start = chrono::steady_clock::now();
+  ifstream big(path);
+  scan_stream(big, reference);
+  double secs = seconds_since(start);
+  cout << "getline + stringstream " << setw(8) << fixed << setprecision(1) << mb / secs << " MB/s" << endl;
 
-  // group by species
-  for (size_t i = 0; i < records.size(); ++i) {
-    if (records[i].species == "Iris-setosa") {
-      setosa.sepal_length.push_back(records[i].sepal_length);
-      setosa.sepal_width.push_back(records[i].sepal_width);
-      setosa.petal_length.push_back(records[i].petal_length);
-      setosa.petal_width.push_back(records[i].petal_width);
-    }
-    else if (records[i].species == "Iris-versicolor") {
-      versicolor.sepal_length.push_back(records[i].sepal_length);
-      versicolor.sepal_width.push_back(records[i].sepal_width);
-      versicolor.petal_length.push_back(records[i].petal_length);
-      versicolor.petal_width.push_back(records[i].petal_width);
+  int status = 0;
+  for (unsigned threads = 1; ; threads = min(threads * 2, max_threads)) {
+    IrisSummary summary;
+    start = chrono::steady_clock::now();
+    scan_file(path, threads, summary);
+    secs = seconds_since(start);
+    double diff = max_difference(reference, summary);
+    cout << "mapped, " << setw(3) << threads << " threads     " << setw(8) << mb / secs << " MB/s, "
+         << summary.rows() << " rows" << endl;
+    if (diff > 1e-9) {
+      cerr << "Error: results differ from getline (" << diff << ")" << endl;
+      status = 1;
     }
-    else if (records[i].species == "Iris-virginica") {
-      virginica.sepal_length.push_back(records[i].sepal_length);
-      virginica.sepal_width.push_back(records[i].sepal_width);
-      virginica.petal_length.push_back(records[i].petal_length);
-      virginica.petal_width.push_back(records[i].petal_width);
+    if (threads >= max_threads) {
+      break;
     }
   }
+  remove(path);
+  return status;
+}
+
+int main(int argc, char *argv[]) {
+  string mode = argc > 1 ? argv[1] : "";
+  if (mode == "bench") {
+    unsigned cores = thread::hardware_concurrency();
+    return bench(argc > 2 ? strtoul(argv[2], NULL, 10) : 100000, max(1, argc > 3 ? atoi(argv[3]) : (int)cores));
+  }
 
-  print_table(setosa, versicolor, virginica);
+  const char *path = argc > 1 ? argv[1] : "iris.txt";
+  unsigned threads = max(1, argc > 2 ? atoi(argv[2]) : (int)thread::hardware_concurrency());
+  IrisSummary summary;
+  if (!scan_file(path, threads, summary)) {
+    cerr << "Error opening " << path << endl;
+    return 1;
+  }
+
+  print_table(summary);
 
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,155 @@
+#include <cstring>
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+#include "multiboard.h"
+
+// For guess letter i that isn't green on a board: yellow while fewer of the
+// guess's earlier non-green copies of the letter came before it than the
+// answer has unmatched copies. The earlier copies are the same positions
+// on every board, only whether they are green differs.
+struct GuessShape {
+  uint8_t letter[MAX_WORD_LENGTH];
+  int first[MAX_WORD_LENGTH]; // first position with the same letter
+};
+
+template <int N>
+static GuessShape shape_of(typename WordShape<N>::Packed guess) {
+  GuessShape s;
+  for (int i = 0; i < N; ++i) {
+    s.letter[i] = (uint8_t)word_letter_n<N>(guess, i);
+    s.first[i] = i;
+    for (int k = i - 1; k >= 0; --k) {
+      if (s.letter[k] == s.letter[i]) {
+        s.first[i] = k;
+      }
+    }
+  }
+  return s;
+}
+
+template <int N>
+void score_boards_scalar(typename WordShape<N>::Packed guess, const uint8_t (*planes)[MAX_BOARDS], int boards,
+                         int* patterns) {
+  GuessShape s = shape_of<N>(guess);
+  for (int b = 0; b < boards; ++b) {
+    bool green[N];
+    for (int i = 0; i < N; ++i) {
+      green[i] = planes[i][b] == s.letter[i];
+    }
+    int pattern = 0;
+    for (int i = N - 1; i >= 0; --i) {
+      int digit = FEEDBACK_GREEN;
+      if (!green[i]) {
+        int avail = 0, rank = 0;
+        for (int j = 0; j < N; ++j) {
+          avail += !green[j] && planes[j][b] == s.letter[i];
+        }
+        for (int k = s.first[i]; k < i; ++k) {
+          rank += s.letter[k] == s.letter[i] && !green[k];
+        }
+        digit = rank < avail ? FEEDBACK_YELLOW : FEEDBACK_GRAY;
+      }
+      pattern = pattern * 3 + digit;
+    }
+    patterns[b] = pattern;
+  }
+}
+
+#if defined(__x86_64__)
+template <int N>
+void score_boards(typename WordShape<N>::Packed guess, const uint8_t (*planes)[MAX_BOARDS], int boards, int* patterns) {
+  GuessShape s = shape_of<N>(guess);
+  __m128i letter[N], green[N], answer[N], avail[N];
+  for (int i = 0; i < N; ++i) {
+    letter[i] = _mm_set1_epi8((char)s.letter[i]);
+    answer[i] = _mm_loadu_si128((const __m128i*)planes[i]);
+    green[i] = _mm_cmpeq_epi8(answer[i], letter[i]);
+  }
+  // unmatched copies in each answer of each guess letter; compares are
+  // -1, so subtracting them counts up
+#pragma GCC unroll 8
+  for (int i = 0; i < N; ++i) {
+    avail[i] = _mm_setzero_si128();
+#pragma GCC unroll 8
+    for (int j = 0; j < N; ++j) {
+      avail[i] = _mm_sub_epi8(avail[i], _mm_andnot_si128(green[j], _mm_cmpeq_epi8(answer[j], letter[i])));
+    }
+  }
+
+  // Horner's rule from the last letter, in 16-bit lanes since patterns
+  // reach 3^8
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i three = _mm_set1_epi16(3);
+  __m128i lo = zero, hi = zero;
+#pragma GCC unroll 8
+  for (int i = N - 1; i >= 0; --i) {
+    __m128i rank = zero;
+#pragma GCC unroll 8
+    for (int k = 0; k < i; ++k) {
+      __m128i same = _mm_set1_epi8(s.letter[k] == s.letter[i] ? -1 : 0);
+      rank = _mm_sub_epi8(rank, _mm_andnot_si128(green[k], same));
+    }
+    __m128i yellow = _mm_andnot_si128(green[i], _mm_cmpgt_epi8(avail[i], rank));
+    __m128i digit = _mm_or_si128(_mm_and_si128(green[i], _mm_set1_epi8(FEEDBACK_GREEN)),
+                                 _mm_and_si128(yellow, _mm_set1_epi8(FEEDBACK_YELLOW)));
+    lo = _mm_add_epi16(_mm_mullo_epi16(lo, three), _mm_unpacklo_epi8(digit, zero));
+    hi = _mm_add_epi16(_mm_mullo_epi16(hi, three), _mm_unpackhi_epi8(digit, zero));
+  }
+  uint16_t out[MAX_BOARDS];
+  _mm_storeu_si128((__m128i*)out, lo);
+  _mm_storeu_si128((__m128i*)(out + 8), hi);
+  for (int b = 0; b < boards; ++b) {
+    patterns[b] = out[b];
+  }
+}
+#else
+template <int N>
+void score_boards(typename WordShape<N>::Packed guess, const uint8_t (*planes)[MAX_BOARDS], int boards, int* patterns) {
+  score_boards_scalar<N>(guess, planes, boards, patterns);
+}
+#endif
+
+template <int N>
+void MultiBoard<N>::start(const Packed* answers, int boards, int max_attempts) {
+  m_boards = boards;
+  m_attempts = 0;
+  m_max_attempts = max_attempts > 0 ? max_attempts : boards + 5;
+  m_solved = 0;
+  // unused lanes hold a letter no guess has, so they are never green
+  memset(m_planes, 31, sizeof(m_planes));
+  for (int b = 0; b < boards; ++b) {
+    m_answers[b] = answers[b];
+    for (int i = 0; i < N; ++i) {
+      m_planes[i][b] = (uint8_t)word_letter_n<N>(answers[b], i);
+    }
+  }
+}
+
+template <int N>
+int MultiBoard<N>::guess(Packed word, int* patterns) {
+  // sharing only pays from two boards on
+  if (m_boards == 1) {
+    patterns[0] = score_guess_n<N>(word, m_answers[0]);
+  } else {
+    score_boards<N>(word, m_planes, m_boards, patterns);
+  }
+  for (int b = 0; b < m_boards; ++b) {
+    if (patterns[b] == WordShape<N>::ALL_GREEN) {
+      m_solved |= 1u << b;
+    }
+  }
+  ++m_attempts;
+  return solved_count();
+}
+
+#define INSTANTIATE(N)                                                                                          \
+  template void score_boards<N>(WordShape<N>::Packed, const uint8_t (*)[MAX_BOARDS], int, int*);               \
+  template void score_boards_scalar<N>(WordShape<N>::Packed, const uint8_t (*)[MAX_BOARDS], int, int*);        \
+  template class MultiBoard<N>;
+
+INSTANTIATE(4)
+INSTANTIATE(5)
+INSTANTIATE(6)
+INSTANTIATE(7)
+INSTANTIATE(8)
@@ -0,0 +1,58 @@
+#ifndef __MULTIBOARD_H__
+#define __MULTIBOARD_H__
+#include <cstddef>
+#include <cstdint>
+#include "variant.h"
+
+const int MAX_BOARDS = 16;
+
+// Scores guess against the answers of boards boards at once. Answers are
+// given as letter planes, planes[i][b] the letter at i of board b's answer.
+// The guess side (which positions repeat a letter) is worked out once,
+// then each step covers every board: with SSE2, one compare handles all
+// 16, so 16 boards cost about what one does. Same patterns as
+// score_guess_n(), into patterns[b] for b < boards.
+template <int N>
+void score_boards(typename WordShape<N>::Packed guess, const uint8_t (*planes)[MAX_BOARDS], int boards, int* patterns);
+// the same one board at a time, for checking and comparison
+template <int N>
+void score_boards_scalar(typename WordShape<N>::Packed guess, const uint8_t (*planes)[MAX_BOARDS], int boards,
+                         int* patterns);
+
+// Several boards played with the same guesses, each with its own answer
+// (Quordle with 4 boards, Octordle with 8, Sedecordle with 16). Instantiated
+// for 4 to 8 letters.
+template <int N>
+class MultiBoard {
+public:
+  typedef typename WordShape<N>::Packed Packed;
+
+  MultiBoard() : m_boards(0), m_attempts(0), m_max_attempts(0), m_solved(0) {}
+
+  // at most MAX_BOARDS answers; max_attempts 0 means boards + 5, the usual
+  // 6 for one board and 9 for Quordle
+  void start(const Packed* answers, int boards, int max_attempts = 0);
+  // scores word on every board, patterns[b] for b < boards() (boards
+  // solved before stay solved whatever the pattern); returns how many
+  // boards are solved now
+  int guess(Packed word, int* patterns);
+
+  int boards() const { return m_boards; }
+  int attempts() const { return m_attempts; }
+  int max_attempts() const { return m_max_attempts; }
+  Packed answer(int b) const { return m_answers[b]; }
+  bool solved(int b) const { return (m_solved >> b) & 1; }
+  int solved_count() const { return __builtin_popcount(m_solved); }
+  bool won() const { return solved_count() == m_boards; }
+  bool over() const { return won() || m_attempts >= m_max_attempts; }
+
+private:
+  uint8_t m_planes[N][MAX_BOARDS];
+  Packed m_answers[MAX_BOARDS];
+  int m_boards;
+  int m_attempts;
+  int m_max_attempts;
+  uint32_t m_solved;
+};
+
+#endif
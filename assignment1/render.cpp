@@ -0,0 +1,109 @@
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include "render.h"
+
+using namespace std;
+
+// indexed by Feedback, gray is the terminal's own color
+static const char* const ESCAPES[3] = {"\033[0m", "\033[93m", "\033[92m"};
+static const size_t ESCAPE_LENGTH[3] = {4, 5, 5};
+
+// worst case for one board: an escape before every letter, then a reset
+static const size_t BOARD_BYTES = MAX_ATTEMPTS * (WORD_LENGTH * 6 + 1) + 4;
+
+BoardRenderer::BoardRenderer(bool color, size_t capacity)
+  : m_buf(max(capacity, BOARD_BYTES)), m_len(0), m_color(color), m_current(FEEDBACK_GRAY) {}
+
+void BoardRenderer::reserve(size_t extra) {
+  if (m_len + extra > m_buf.size()) {
+    m_buf.resize(max(m_buf.size() * 2, m_len + extra));
+  }
+}
+
+void BoardRenderer::append(const char* s, size_t len) {
+  reserve(len);
+  memcpy(&m_buf[m_len], s, len);
+  m_len += len;
+}
+
+void BoardRenderer::set_color(int color) {
+  if (color != m_current) {
+    append(ESCAPES[color], ESCAPE_LENGTH[color]);
+    m_current = color;
+  }
+}
+
+void BoardRenderer::board(const GameSession& game) {
+  reserve(BOARD_BYTES);
+  char* out = &m_buf[m_len];
+  for (int i = 0; i < MAX_ATTEMPTS; ++i) {
+    if (i >= game.attempts) {
+      if (m_color && m_current != FEEDBACK_GRAY) {
+        memcpy(out, ESCAPES[FEEDBACK_GRAY], ESCAPE_LENGTH[FEEDBACK_GRAY]);
+        out += ESCAPE_LENGTH[FEEDBACK_GRAY];
+        m_current = FEEDBACK_GRAY;
+      }
+      memset(out, '*', WORD_LENGTH);
+      out += WORD_LENGTH;
+      *out++ = '\n';
+      continue;
+    }
+    PackedWord guess = game.guesses[i];
+    int pattern = game.patterns[i];
+    if (m_color) {
+      for (int j = 0; j < WORD_LENGTH; ++j) {
+        int color = pattern % 3;
+        pattern /= 3;
+        if (color != m_current) {
+          memcpy(out, ESCAPES[color], ESCAPE_LENGTH[color]);
+          out += ESCAPE_LENGTH[color];
+          m_current = color;
+        }
+        *out++ = 'a' + word_letter(guess, j);
+      }
+    } else {
+      for (int j = 0; j < WORD_LENGTH; ++j) {
+        out[j] = 'a' + word_letter(guess, j);
+        out[WORD_LENGTH + 1 + j] = ".YG"[pattern % 3];
+        pattern /= 3;
+      }
+      out[WORD_LENGTH] = ' ';
+      out += 2 * WORD_LENGTH + 1;
+    }
+    *out++ = '\n';
+  }
+  m_len = out - m_buf.data();
+  if (m_color) {
+    set_color(FEEDBACK_GRAY);
+  }
+}
+
+void BoardRenderer::word(const string& word, Feedback color) {
+  if (m_color) {
+    set_color(color);
+    text(word);
+    set_color(FEEDBACK_GRAY);
+  } else {
+    text(word);
+  }
+}
+
+bool BoardRenderer::flush(int fd) {
+  const char* p = m_buf.data();
+  size_t len = m_len;
+  m_len = 0;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool stdout_wants_color() {
+  return isatty(STDOUT_FILENO) && getenv("NO_COLOR") == NULL;
+}
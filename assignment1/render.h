@@ -0,0 +1,50 @@
+#ifndef __RENDER_H__
+#define __RENDER_H__
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "feedback.h"
+#include "game.h"
+
+// Composes board output into one buffer that flush() hands to the kernel
+// in a single write. In color mode a color escape is only emitted when the
+// color changes, so a row of grays costs no escapes at all and each run of
+// same colored letters shares one. Plain mode has no escapes; each row is
+// the guess followed by its feedback (G green, Y yellow, . gray).
+class BoardRenderer {
+public:
+  BoardRenderer(bool color, size_t capacity = 1 << 16);
+
+  // six rows, '*' for the ones not played yet
+  void board(const GameSession& game);
+  // word in a single feedback color, e.g. the target in green
+  void word(const std::string& word, Feedback color);
+  void text(const std::string& s) { append(s.data(), s.size()); }
+  void text(const char* s, size_t len) { append(s, len); }
+
+  // writes everything buffered so far to fd and empties the buffer
+  bool flush(int fd);
+  void clear() { m_len = 0; }
+  const char* data() const { return m_buf.data(); }
+  size_t size() const { return m_len; }
+  bool color() const { return m_color; }
+
+private:
+  void set_color(int color);
+  void reserve(size_t extra);
+  void append(const char* s, size_t len);
+  void put(char c) {
+    reserve(1);
+    m_buf[m_len++] = c;
+  }
+
+  std::vector<char> m_buf;
+  size_t m_len;
+  bool m_color;
+  int m_current; // feedback color the terminal is in, gray is the default
+};
+
+// color unless stdout isn't a terminal or NO_COLOR is set
+bool stdout_wants_color();
+
+#endif
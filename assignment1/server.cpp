@@ -0,0 +1,398 @@
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+
+using namespace std;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE is ignored instead
+#endif
+
+// replies a client hasn't taken yet, beyond which its requests wait
+static const size_t MAX_BACKLOG = 1 << 20;
+// longest unfinished request kept; protocol lines are a few dozen bytes
+static const size_t MAX_LINE = 4096;
+
+// splits off the next space separated token of [p, end)
+static bool next_token(const char*& p, const char* end, const char*& tok, size_t& len) {
+  while (p < end && *p == ' ') {
+    ++p;
+  }
+  tok = p;
+  while (p < end && *p != ' ' && *p != '\r') {
+    ++p;
+  }
+  len = p - tok;
+  return len > 0;
+}
+
+static bool parse_id(const char* tok, size_t len, uint64_t& id) {
+  id = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if (tok[i] < '0' || tok[i] > '9') {
+      return false;
+    }
+    id = id * 10 + (tok[i] - '0');
+  }
+  return len > 0;
+}
+
+static void append_feedback(string& out, int pattern) {
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    out += ".YG"[pattern_digit(pattern, i)];
+  }
+}
+
+GameServer::GameServer(const WordList& words, const WordIndex& index, size_t capacity, unsigned seed)
+  : m_words(words), m_index(index), m_sessions(capacity), m_rng(seed) {}
+
+void GameServer::handle(const char* line, size_t len, string& out) {
+  const char* p = line;
+  const char* end = line + len;
+  const char* cmd;
+  size_t cmd_len;
+  const char* arg;
+  size_t arg_len;
+  if (!next_token(p, end, cmd, cmd_len)) {
+    out += "ERR empty request\n";
+    return;
+  }
+  string command(cmd, cmd_len);
+
+  if (command == "NEW") {
+    PackedWord target;
+    if (next_token(p, end, arg, arg_len)) {
+      if (!pack_word(arg, arg_len, target) || !m_index.contains(target)) {
+        out += "ERR invalid word\n";
+        return;
+      }
+    } else {
+      target = m_words[uniform_int_distribution<size_t>(0, m_words.size() - 1)(m_rng)];
+    }
+    uint64_t id;
+    if (!m_sessions.create(target, id)) {
+      out += "ERR server full\n";
+      return;
+    }
+    out += "OK " + to_string(id) + "\n";
+    return;
+  }
+  if (command == "STATS") {
+    out += "OK " + to_string(m_sessions.active()) + " " + to_string(m_sessions.capacity()) + "\n";
+    return;
+  }
+
+  uint64_t id;
+  GameSession* game = NULL;
+  if (!next_token(p, end, arg, arg_len) || !parse_id(arg, arg_len, id) || !(game = m_sessions.find(id))) {
+    out += "ERR no such game\n";
+    return;
+  }
+
+  if (command == "GUESS") {
+    PackedWord word;
+    if (!next_token(p, end, arg, arg_len) || !pack_word(arg, arg_len, word) || !m_index.contains(word)) {
+      out += "ERR invalid word\n";
+      return;
+    }
+    if (game->state != GAME_PLAYING) {
+      out += "ERR game over\n";
+      return;
+    }
+    int pattern = game->guess(word);
+    out += "OK ";
+    append_feedback(out, pattern);
+    if (game->state == GAME_PLAYING) {
+      out += " PLAYING\n";
+    } else {
+      out += game->state == GAME_WON ? " WON " : " LOST ";
+      out += unpack_word(game->target) + "\n";
+    }
+  } else if (command == "BOARD") {
+    out += "OK";
+    for (int i = 0; i < game->attempts; ++i) {
+      out += " " + unpack_word(game->guesses[i]) + ":";
+      append_feedback(out, game->patterns[i]);
+    }
+    out += "\n";
+  } else if (command == "END") {
+    m_sessions.close(id);
+    out += "OK\n";
+  } else {
+    out += "ERR unknown command\n";
+  }
+}
+
+int GameServer::serve_stream(FILE* in, FILE* out) {
+  char* line = NULL;
+  size_t cap = 0;
+  ssize_t len;
+  string reply;
+  while ((len = getline(&line, &cap, in)) > 0) {
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+      --len;
+    }
+    if (len == 4 && memcmp(line, "QUIT", 4) == 0) {
+      break;
+    }
+    reply.clear();
+    handle(line, len, reply);
+    fwrite(reply.data(), 1, reply.size(), out);
+    fflush(out);
+  }
+  free(line);
+  return 0;
+}
+
+// writes all of buf to a blocking socket, false if the peer went away
+static bool write_all(int fd, const char* buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    buf += n;
+    len -= n;
+  }
+  return true;
+}
+
+// A connection to serve_socket(): the partial request line read so far and
+// the replies not yet sent. Reading stops once the client has closed its
+// side or sent QUIT, or while it lets too many replies pile up.
+struct Client {
+  string in;
+  string out;
+  size_t sent;
+  bool closing;
+
+  Client() : sent(0), closing(false) {}
+};
+
+// sends what the socket takes without blocking, false if the peer went away
+static bool flush_client(int fd, Client& client) {
+  while (client.sent < client.out.size()) {
+    ssize_t n = send(fd, client.out.data() + client.sent, client.out.size() - client.sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      client.sent += n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+  }
+  client.out.clear();
+  client.sent = 0;
+  return true;
+}
+
+int GameServer::serve_socket(const char* path) {
+  // a client that hangs up before reading its replies must not take the
+  // server down with it
+  signal(SIGPIPE, SIG_IGN);
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+    cerr << "Error: Could not listen on " << path << endl;
+    return 1;
+  }
+
+  vector<pollfd> fds(1);
+  fds[0].fd = listener;
+  fds[0].events = POLLIN;
+  vector<Client> clients(1); // clients[c] goes with fds[c]
+  char buf[1 << 16];
+  while (true) {
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[0].revents & POLLIN) {
+      int client = accept(listener, NULL, NULL);
+      if (client >= 0) {
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+        pollfd pfd = {client, POLLIN, 0};
+        fds.push_back(pfd);
+        clients.push_back(Client());
+      }
+    }
+    for (size_t c = fds.size(); c-- > 1; ) {
+      if (!fds[c].revents) {
+        continue;
+      }
+      Client& client = clients[c];
+      bool open = true;
+      if ((fds[c].events & POLLIN) && (fds[c].revents & (POLLIN | POLLHUP | POLLERR))) {
+        ssize_t n = read(fds[c].fd, buf, sizeof(buf));
+        if (n > 0) {
+          // every complete line gets its reply, queued up to go out together
+          client.in.append(buf, n);
+          size_t start = 0, eol;
+          while (!client.closing && (eol = client.in.find('\n', start)) != string::npos) {
+            size_t len = eol - start;
+            if (len > 0 && client.in[eol - 1] == '\r') {
+              --len;
+            }
+            if (len == 4 && client.in.compare(start, 4, "QUIT") == 0) {
+              client.closing = true;
+            } else {
+              handle(client.in.data() + start, len, client.out);
+            }
+            start = eol + 1;
+          }
+          client.in.erase(0, start);
+          if (!client.closing && client.in.size() > MAX_LINE) {
+            client.out += "ERR line too long\n";
+            client.closing = true;
+          }
+          if (client.closing) {
+            client.in.clear();
+          }
+        } else if (n == 0) {
+          client.closing = true; // replies still go out if it only shut down writing
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          open = false;
+        }
+      }
+      open = open && flush_client(fds[c].fd, client);
+      if (client.closing && client.out.empty()) {
+        open = false;
+      }
+      if (!open) {
+        close(fds[c].fd);
+        fds.erase(fds.begin() + c);
+        clients.erase(clients.begin() + c);
+        continue;
+      }
+      bool backlog = client.out.size() - client.sent > MAX_BACKLOG;
+      fds[c].events = (client.closing || backlog ? 0 : POLLIN) | (client.out.empty() ? 0 : POLLOUT);
+    }
+  }
+  close(listener);
+  return 0;
+}
+
+bool connect_socket(const char* path, function<void(const string&, string&)>& request) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  // the connection closes with the last copy of request
+  signal(SIGPIPE, SIG_IGN);
+  shared_ptr<int> conn(new int(fd), [](int* f) { close(*f); delete f; });
+  shared_ptr<string> buffered(new string());
+  request = [conn, buffered](const string& line, string& reply) {
+    string msg = line + "\n";
+    reply.clear();
+    if (!write_all(*conn, msg.data(), msg.size())) {
+      return;
+    }
+    char buf[4096];
+    size_t eol;
+    while ((eol = buffered->find('\n')) == string::npos) {
+      ssize_t n = read(*conn, buf, sizeof(buf));
+      if (n <= 0) {
+        return;
+      }
+      buffered->append(buf, n);
+    }
+    reply.assign(*buffered, 0, eol);
+    buffered->erase(0, eol + 1);
+  };
+  return true;
+}
+
+int run_load_generator(const function<void(const string&, string&)>& request,
+                       const WordList& words, size_t games, size_t concurrent, unsigned seed) {
+  if (games == 0 || concurrent == 0) {
+    cout << "no games to play" << endl;
+    return 0;
+  }
+  mt19937 rng(seed);
+  uniform_int_distribution<size_t> pick(0, words.size() - 1);
+  vector<string> open; // ids of the games in play
+  vector<uint32_t> latency_ns;
+  latency_ns.reserve(games * MAX_ATTEMPTS);
+  string reply;
+  size_t started = 0, finished = 0, won = 0;
+
+  auto start_game = [&]() -> bool {
+    request("NEW", reply);
+    if (reply.compare(0, 3, "OK ") != 0) {
+      cerr << "Error: NEW failed: " << reply << endl;
+      return false;
+    }
+    open.push_back(reply.substr(3));
+    ++started;
+    return true;
+  };
+
+  auto begin = chrono::steady_clock::now();
+  while (started < min(games, concurrent)) {
+    if (!start_game()) {
+      return 1;
+    }
+  }
+  // one guess per open game per pass, games that end are replaced
+  while (!open.empty()) {
+    for (size_t g = 0; g < open.size(); ) {
+      string req = "GUESS " + open[g] + " " + words.word(pick(rng));
+      auto t = chrono::steady_clock::now();
+      request(req, reply);
+      latency_ns.push_back((uint32_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t).count());
+      if (reply.compare(0, 3, "OK ") != 0) {
+        cerr << "Error: " << req << ": " << reply << endl;
+        return 1;
+      }
+      if (reply.find("PLAYING") != string::npos) {
+        ++g;
+        continue;
+      }
+      won += reply.find("WON") != string::npos;
+      ++finished;
+      request("END " + open[g], reply);
+      open[g] = open.back();
+      open.pop_back();
+      if (started < games && !start_game()) {
+        return 1;
+      }
+    }
+  }
+  double secs = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+  sort(latency_ns.begin(), latency_ns.end());
+  auto pct = [&](double q) { return latency_ns[min(latency_ns.size() - 1, (size_t)(q * latency_ns.size()))] / 1e3; };
+  cout << finished << " games (" << won << " won), " << latency_ns.size() << " guesses, "
+       << concurrent << " concurrent, in " << secs << " s" << endl;
+  cout << finished / secs << " games/s, " << latency_ns.size() / secs << " guesses/s" << endl;
+  cout << "guess latency us: p50 " << pct(0.50) << ", p99 " << pct(0.99) << ", max " << latency_ns.back() / 1e3 << endl;
+  return 0;
+}
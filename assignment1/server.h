@@ -0,0 +1,57 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <random>
+#include <functional>
+#include "game.h"
+#include "wordindex.h"
+#include "wordlist.h"
+
+// Line protocol front end for a SessionTable. One request per line, one
+// reply line each:
+//
+//   NEW [word]          OK <id>              (random target unless given)
+//   GUESS <id> <word>   OK <feedback> PLAYING|WON|LOST <target if over>
+//   BOARD <id>          OK <guess>:<feedback> ...
+//   END <id>            OK
+//   STATS               OK <active games> <capacity>
+//
+// Feedback has one character per letter: G green, Y yellow, . gray.
+// Failures reply ERR <reason>.
+class GameServer {
+public:
+  GameServer(const WordList& words, const WordIndex& index, size_t capacity, unsigned seed);
+
+  // line has no newline; the reply, newline included, is appended to out
+  void handle(const char* line, size_t len, std::string& out);
+  // requests from in until EOF or QUIT, replies to out
+  int serve_stream(FILE* in, FILE* out);
+  // a Unix domain socket at path, any number of clients multiplexed with
+  // poll() on non-blocking sockets, each with its own queue of replies, so
+  // a client that stops reading holds up only itself; a client sends QUIT
+  // to disconnect, and one sending a line over 4 KB gets "ERR line too
+  // long" and is disconnected
+  int serve_socket(const char* path);
+
+  SessionTable& sessions() { return m_sessions; }
+
+private:
+  const WordList& m_words;
+  const WordIndex& m_index;
+  SessionTable m_sessions;
+  std::mt19937 m_rng;
+};
+
+// Plays games through request(line, reply) with concurrent games open at
+// a time, random dictionary guesses, until games have finished. Reports
+// games/s and guess latency percentiles to stdout.
+int run_load_generator(const std::function<void(const std::string&, std::string&)>& request,
+                       const WordList& words, size_t games, size_t concurrent, unsigned seed);
+
+// request() over a connection to serve_socket(); false if it can't connect
+bool connect_socket(const char* path, std::function<void(const std::string&, std::string&)>& request);
+
+#endif
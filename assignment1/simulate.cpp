@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include "simulate.h"
+
+using namespace std;
+
+// games per parallel chunk
+static const size_t GAME_GRAIN = 16;
+
+uint32_t FirstCandidateStrategy::guess(const vector<uint32_t>& candidates, uint64_t /*history*/,
+                                       mt19937_64& /*rng*/) {
+  return candidates[0];
+}
+
+uint32_t RandomCandidateStrategy::guess(const vector<uint32_t>& candidates, uint64_t /*history*/, mt19937_64& rng) {
+  return candidates[uniform_int_distribution<size_t>(0, candidates.size() - 1)(rng)];
+}
+
+EntropyStrategy::EntropyStrategy(const PatternTable& table) : m_solver(table, NULL) {
+  vector<uint32_t> all(table.num_answers());
+  for (size_t a = 0; a < all.size(); ++a) {
+    all[a] = (uint32_t)a;
+  }
+  m_cache[0] = (uint32_t)m_solver.best_guess(all);
+}
+
+uint32_t EntropyStrategy::guess(const vector<uint32_t>& candidates, uint64_t history, mt19937_64& /*rng*/) {
+  {
+    lock_guard<mutex> hold(m_lock);
+    unordered_map<uint64_t, uint32_t>::const_iterator it = m_cache.find(history);
+    if (it != m_cache.end()) {
+      return it->second;
+    }
+  }
+  uint32_t g = (uint32_t)m_solver.best_guess(candidates);
+  lock_guard<mutex> hold(m_lock);
+  m_cache[history] = g;
+  return g;
+}
+
+SimulationResult simulate(const WordList& words, const vector<uint32_t>& targets, Strategy& strategy,
+                          ThreadPool& pool, uint64_t seed) {
+  CandidateSet all;
+  all.assign(words.begin(), words.size());
+  vector<uint8_t> depth(targets.size()); // 0 when the game was lost
+
+  auto start = chrono::steady_clock::now();
+  pool.parallelFor(0, targets.size(), GAME_GRAIN, [&](size_t begin, size_t end) {
+    CandidateSet candidates;
+    for (size_t g = begin; g < end; ++g) {
+      mt19937_64 rng(seed + 0x9E3779B97F4A7C15ULL * (g + 1));
+      GameSession game;
+      game.start(words[targets[g]]);
+      const CandidateSet* left = &all;
+      uint64_t history = 0;
+      while (game.state == GAME_PLAYING) {
+        PackedWord guess = words[strategy.guess(left->ids(), history, rng)];
+        int pattern = game.guess(guess);
+        history |= (uint64_t)(pattern + 1) << (8 * (game.attempts - 1));
+        candidates.filter_from(*left, guess, pattern);
+        left = &candidates;
+      }
+      depth[g] = game.state == GAME_WON ? game.attempts : 0;
+    }
+  });
+
+  SimulationResult result;
+  result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  result.games = targets.size();
+  result.guesses = 0;
+  fill(result.depths, result.depths + MAX_ATTEMPTS + 1, 0);
+  for (size_t g = 0; g < depth.size(); ++g) {
+    ++result.depths[depth[g]];
+    result.guesses += depth[g] ? depth[g] : MAX_ATTEMPTS;
+  }
+  result.failed = result.depths[0];
+  result.depths[0] = 0;
+  return result;
+}
+
+vector<uint32_t> sample_targets(size_t num_words, size_t count, uint64_t seed) {
+  vector<uint32_t> all(num_words);
+  for (size_t i = 0; i < num_words; ++i) {
+    all[i] = (uint32_t)i;
+  }
+  if (count == 0 || count >= num_words) {
+    return all;
+  }
+  vector<uint32_t> targets;
+  targets.reserve(count);
+  mt19937_64 rng(seed);
+  sample(all.begin(), all.end(), back_inserter(targets), count, rng);
+  return targets;
+}
@@ -0,0 +1,76 @@
+#ifndef __SIMULATE_H__
+#define __SIMULATE_H__
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "feedback.h"
+#include "candidates.h"
+#include "game.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "wordlist.h"
+
+// A way of picking guesses. Words are indices into the simulation's word
+// list; candidates are the words still consistent with every feedback so
+// far, and history has one byte per guess so far, pattern + 1. guess() is
+// called from many threads at once, rng is the calling game's own.
+class Strategy {
+public:
+  virtual ~Strategy() {}
+  virtual const char* name() const = 0;
+  virtual uint32_t guess(const std::vector<uint32_t>& candidates, uint64_t history, std::mt19937_64& rng) = 0;
+};
+
+// the first remaining candidate in alphabetical order
+class FirstCandidateStrategy : public Strategy {
+public:
+  const char* name() const { return "first"; }
+  uint32_t guess(const std::vector<uint32_t>& candidates, uint64_t history, std::mt19937_64& rng);
+};
+
+// a uniformly random remaining candidate
+class RandomCandidateStrategy : public Strategy {
+public:
+  const char* name() const { return "random"; }
+  uint32_t guess(const std::vector<uint32_t>& candidates, uint64_t history, std::mt19937_64& rng);
+};
+
+// EntropySolver's choice, cached per feedback history and shared by all
+// games. The opening guess is worked out up front; two games reaching a
+// new history at the same time may both compute it, with the same result.
+class EntropyStrategy : public Strategy {
+public:
+  EntropyStrategy(const PatternTable& table);
+  const char* name() const { return "entropy"; }
+  uint32_t guess(const std::vector<uint32_t>& candidates, uint64_t history, std::mt19937_64& rng);
+
+private:
+  EntropySolver m_solver;
+  std::mutex m_lock;
+  std::unordered_map<uint64_t, uint32_t> m_cache;
+};
+
+struct SimulationResult {
+  size_t games;
+  size_t failed;                         // not solved in MAX_ATTEMPTS
+  size_t depths[MAX_ATTEMPTS + 1];       // games solved in each number of guesses
+  uint64_t guesses;                      // failed games count MAX_ATTEMPTS
+  double seconds;
+};
+
+// Plays a game against every target with the strategy, spread over the
+// pool. Feedback comes from score_guess() and candidates are narrowed by
+// CandidateSet, so no pattern table is needed unless the strategy has one.
+// Game g's rng is seeded from seed and g alone, so results don't depend on
+// the thread count.
+SimulationResult simulate(const WordList& words, const std::vector<uint32_t>& targets, Strategy& strategy,
+                          ThreadPool& pool, uint64_t seed);
+
+// count targets drawn without replacement (every word when count is 0 or
+// at least the list size), in list order
+std::vector<uint32_t> sample_targets(size_t num_words, size_t count, uint64_t seed);
+
+#endif
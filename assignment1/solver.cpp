@@ -0,0 +1,143 @@
+#include <cmath>
+#include <algorithm>
+#include "solver.h"
+
+using namespace std;
+
+// guesses per parallel chunk
+static const size_t GUESS_GRAIN = 256;
+// give up on a game after this many guesses (can't happen with a full table)
+static const int MAX_DEPTH = 8;
+
+// a lower sum of k log2 k wins; within rounding, a guess that could be the
+// answer beats one that can't
+static bool better(double sum, bool cand, double best, bool best_cand) {
+  return sum < best - 1e-9 || (sum < best + 1e-9 && cand && !best_cand);
+}
+
+EntropySolver::EntropySolver(const PatternTable& table, ThreadPool* pool)
+  : m_table(table), m_pool(pool), m_pairs(0) {
+  unordered_map<PackedWord, long> index;
+  for (size_t a = 0; a < table.num_answers(); ++a) {
+    index[table.answers()[a]] = (long)a;
+  }
+  m_answer_of.assign(table.num_guesses(), -1);
+  for (size_t g = 0; g < table.num_guesses(); ++g) {
+    unordered_map<PackedWord, long>::const_iterator it = index.find(table.guesses()[g]);
+    if (it != index.end()) {
+      m_answer_of[g] = it->second;
+    }
+  }
+  for (size_t a = 0; a < table.num_answers(); ++a) {
+    m_all.push_back((uint32_t)a);
+  }
+}
+
+size_t EntropySolver::best_guess(const vector<uint32_t>& candidates) {
+  size_t n = candidates.size();
+  if (n == 0) {
+    return NO_GUESS;
+  }
+  if (n <= 2) {
+    // any candidate splits one or two words as well as anything else can,
+    // and might be right
+    for (size_t g = 0; g < m_answer_of.size(); ++g) {
+      if (m_answer_of[g] == (long)candidates[0]) {
+        return g;
+      }
+    }
+  }
+
+  vector<char> is_candidate(m_table.num_answers(), 0);
+  for (size_t i = 0; i < n; ++i) {
+    is_candidate[candidates[i]] = 1;
+  }
+
+  // sum of k log2 k over the partition sizes is all that differs between
+  // guesses: entropy = log2 n - sum / n, so the smallest sum wins
+  size_t num_guesses = m_table.num_guesses();
+  size_t chunks = (num_guesses + GUESS_GRAIN - 1) / GUESS_GRAIN;
+  vector<double> chunk_score(chunks);
+  vector<size_t> chunk_guess(chunks);
+  vector<char> chunk_cand(chunks);
+  auto score = [&](size_t begin, size_t end) {
+    double best = HUGE_VAL;
+    size_t best_g = begin;
+    bool best_cand = false;
+    for (size_t g = begin; g < end; ++g) {
+      uint32_t counts[NUM_PATTERNS] = {0};
+      const uint8_t* row = m_table.row(g);
+      for (size_t i = 0; i < n; ++i) {
+        ++counts[row[candidates[i]]];
+      }
+      double sum = 0;
+      for (int p = 0; p < NUM_PATTERNS; ++p) {
+        if (counts[p] > 1) {
+          sum += counts[p] * log2((double)counts[p]);
+        }
+      }
+      bool cand = m_answer_of[g] >= 0 && is_candidate[m_answer_of[g]];
+      if (better(sum, cand, best, best_cand)) {
+        best = sum;
+        best_g = g;
+        best_cand = cand;
+      }
+    }
+    chunk_score[begin / GUESS_GRAIN] = best;
+    chunk_guess[begin / GUESS_GRAIN] = best_g;
+    chunk_cand[begin / GUESS_GRAIN] = best_cand;
+  };
+  if (m_pool) {
+    m_pool->parallelFor(0, num_guesses, GUESS_GRAIN, score);
+  } else {
+    for (size_t b = 0; b < num_guesses; b += GUESS_GRAIN) {
+      score(b, min(b + GUESS_GRAIN, num_guesses));
+    }
+  }
+  m_pairs += num_guesses * n;
+
+  // chunks in order, so ties go to the lowest index whatever the thread count
+  size_t best = 0;
+  for (size_t c = 1; c < chunks; ++c) {
+    if (better(chunk_score[c], chunk_cand[c], chunk_score[best], chunk_cand[best])) {
+      best = c;
+    }
+  }
+  return chunk_guess[best];
+}
+
+void EntropySolver::prune(size_t guess, int pattern, vector<uint32_t>& candidates) const {
+  const uint8_t* row = m_table.row(guess);
+  size_t kept = 0;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (row[candidates[i]] == pattern) {
+      candidates[kept++] = candidates[i];
+    }
+  }
+  candidates.resize(kept);
+}
+
+int EntropySolver::solve(size_t answer, vector<size_t>* path) {
+  vector<uint32_t> candidates = m_all;
+  uint64_t history = 0; // one byte per guess, pattern + 1
+  for (int depth = 1; depth <= MAX_DEPTH; ++depth) {
+    size_t guess;
+    unordered_map<uint64_t, uint32_t>::const_iterator it = m_cache.find(history);
+    if (it != m_cache.end()) {
+      guess = it->second;
+    } else {
+      guess = best_guess(candidates);
+      m_cache[history] = (uint32_t)guess;
+    }
+    if (path) {
+      path->push_back(guess);
+    }
+    int pattern = m_table.lookup(guess, answer);
+    if (pattern == ALL_GREEN) {
+      return depth;
+    }
+    history |= (uint64_t)(pattern + 1) << (8 * (depth - 1));
+    prune(guess, pattern, candidates);
+  }
+  return MAX_DEPTH + 1;
+}
@@ -0,0 +1,48 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include "feedback.h"
+#include "threadpool.h"
+
+// Automatic player. Each guess is the one whose feedback splits the
+// remaining candidates into the most even partition (highest entropy of
+// the pattern distribution), preferring a candidate answer on ties. Every
+// guess is scored against every candidate through the pattern table, in
+// parallel over guesses when a pool is given.
+//
+// The choice only depends on the feedback seen so far, so solve() caches
+// it per feedback history and a run over the whole answer list only
+// evaluates each node of the decision tree once.
+class EntropySolver {
+public:
+  EntropySolver(const PatternTable& table, ThreadPool* pool);
+
+  static const size_t NO_GUESS = (size_t)-1;
+
+  // candidates are answer indices; returns a guess index, NO_GUESS when
+  // there are no candidates. Without a pool this may be called from
+  // several threads at once.
+  size_t best_guess(const std::vector<uint32_t>& candidates);
+  // keeps the candidates that would have given pattern for this guess
+  void prune(size_t guess, int pattern, std::vector<uint32_t>& candidates) const;
+  // plays until answer is found, returns the number of guesses taken;
+  // path (if given) receives the guess indices
+  int solve(size_t answer, std::vector<size_t>* path = NULL);
+
+  // guess x candidate pairs scored by best_guess() so far
+  uint64_t pairs_scored() const { return m_pairs; }
+
+private:
+  const PatternTable& m_table;
+  ThreadPool* m_pool;
+  std::vector<long> m_answer_of; // answer index of each guess word, -1 if it can't be the answer
+  std::unordered_map<uint64_t, uint32_t> m_cache; // feedback history -> guess
+  std::vector<uint32_t> m_all;
+  std::atomic<uint64_t> m_pairs;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include "threadpool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(size_t nthreads)
+	: m_generation(0), m_active(0), m_stop(false), m_fn(NULL), m_end(0), m_grain(1), m_next(0)
+{
+	for (size_t i = 1; i < nthreads; ++i)
+		m_workers.push_back(thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> guard(m_lock);
+		m_stop = true;
+	}
+	m_start.notify_all();
+	for (size_t i = 0; i < m_workers.size(); ++i)
+		m_workers[i].join();
+}
+
+void ThreadPool::runChunks()
+{
+	while (true) {
+		size_t b = m_next.fetch_add(m_grain);
+		if (b >= m_end)
+			return;
+		(*m_fn)(b, min(b + m_grain, m_end));
+	}
+}
+
+void ThreadPool::workerLoop()
+{
+	size_t seen = 0;
+	while (true) {
+		{
+			unique_lock<mutex> guard(m_lock);
+			m_start.wait(guard, [&] { return m_stop || m_generation != seen; });
+			if (m_stop)
+				return;
+			seen = m_generation;
+		}
+		runChunks();
+		{
+			lock_guard<mutex> guard(m_lock);
+			if (--m_active == 0)
+				m_done.notify_one();
+		}
+	}
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& fn)
+{
+	if (begin >= end)
+		return;
+	if (grain == 0)
+		grain = 1;
+	//not worth waking anybody up for a single chunk
+	if (m_workers.empty() || end - begin <= grain) {
+		for (size_t b = begin; b < end; b += grain)
+			fn(b, min(b + grain, end));
+		return;
+	}
+	{
+		lock_guard<mutex> guard(m_lock);
+		m_fn = &fn;
+		m_end = end;
+		m_grain = grain;
+		m_next = begin;
+		m_active = m_workers.size();
+		++m_generation;
+	}
+	m_start.notify_all();
+	runChunks();
+	unique_lock<mutex> guard(m_lock);
+	m_done.wait(guard, [&] { return m_active == 0; });
+}
@@ -0,0 +1,39 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+//Fixed set of worker threads for fork/join loops. parallelFor() hands out
+//[begin, end) in grain sized chunks from a shared counter; the calling
+//thread works on chunks too and returns once every chunk is done.
+class ThreadPool {
+public:
+	ThreadPool(size_t nthreads); //total threads including the caller
+	~ThreadPool();
+	void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+	size_t size() const { return m_workers.size() + 1; }
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+	void workerLoop();
+	void runChunks();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_lock;
+	std::condition_variable m_start, m_done;
+	size_t m_generation; //bumped for every parallelFor call
+	size_t m_active; //workers still inside the current call
+	bool m_stop;
+
+	const std::function<void(size_t, size_t)>* m_fn;
+	size_t m_end, m_grain;
+	std::atomic<size_t> m_next;
+};
+
+#endif
\ No newline at end of file
@@ -1,15 +1,40 @@
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <sstream>
 #include <string>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include "triangles.h"
 
 using namespace std;
 
+// g++ -std=c++17 -O2 triangle.cpp triangles.cpp threadpool.cpp -pthread -o triangle
+//
+//   ./triangle                            area of one triangle from three
+//                                         points typed in
+//   ./triangle mesh file [threads] [float]
+//                                         areas and orientations of every
+//                                         triangle of an OFF mesh (x and y
+//                                         of each vertex, polygons split
+//                                         into fans), in double or float,
+//                                         on threads (every core by default)
+//   ./triangle bench [triangles] [threads]
+//                                         triangles/s in double and float
+//                                         on 1, 2, 4... up to threads
+
 struct Point {
   double x, y;
 };
 
-int main() {
+void run_interactive() {
 
   Point points[3]; 
   string input;
@@ -25,7 +50,7 @@ int main() {
     cin >> input;
     if (input == "quit") {
       cout << "Exiting..." << endl;
-      return 0;
+      return;
     }
 
     cin.putback(input[0]);
@@ -57,4 +82,251 @@ int main() {
   area = abs(d);
 
   cout << "The area of your triangle is: " << area << endl;
+}
+
+// A mesh as structure of arrays: vertex coordinates and three corner
+// indices per triangle
+template <class Real>
+struct Mesh {
+  vector<Real> x, y;
+  vector<uint32_t> corners;
+
+  size_t triangles() const { return corners.size() / 3; }
+};
+
+// the rest of the current line, as whitespace separated fields
+struct LineReader {
+  const char* p;
+  const char* end;
+
+  // starts the next line that isn't blank or a # comment, false at the end
+  bool next_line() {
+    while (p < end) {
+      while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        ++p;
+      }
+      if (p < end && *p == '#') {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        p = nl ? nl : end;
+        continue;
+      }
+      return p < end;
+    }
+    return false;
+  }
+  void skip_line() {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    p = nl ? nl + 1 : end;
+  }
+  template <class T>
+  bool field(T& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+      ++p;
+    }
+    from_chars_result r = from_chars(p, end, value);
+    p = r.ptr;
+    return r.ec == errc();
+  }
 };
+
+// OFF: "OFF", vertex and face counts (and an edge count), a line of
+// coordinates per vertex, then one per face, "n i1 ... in". Only x and y
+// are used; faces with more than 3 corners become n - 2 triangles.
+template <class Real>
+bool load_off(const char* path, Mesh<Real>& mesh, string& error) {
+  ifstream in(path, ios::binary);
+  if (!in) {
+    error = "could not open " + string(path);
+    return false;
+  }
+  stringstream contents;
+  contents << in.rdbuf();
+  string text = contents.str();
+  LineReader r = {text.data(), text.data() + text.size()};
+
+  if (!r.next_line() || strncmp(r.p, "OFF", 3) != 0) {
+    error = "not an OFF file";
+    return false;
+  }
+  r.p += 3;
+  // every vertex line takes at least 3 bytes ("x y") and every face 7
+  // ("3 a b c"), which also keeps a bad header from asking for terabytes
+  size_t vertices = 0, faces = 0;
+  if (!r.next_line() || !r.field(vertices) || !r.field(faces) || vertices >= (1u << 31) ||
+      vertices > (size_t)(r.end - r.p) / 3 || faces > (size_t)(r.end - r.p) / 7) {
+    error = "bad vertex and face counts";
+    return false;
+  }
+  r.skip_line();
+  mesh.x.resize(vertices);
+  mesh.y.resize(vertices);
+  for (size_t v = 0; v < vertices; ++v) {
+    double x, y;
+    if (!r.next_line() || !r.field(x) || !r.field(y)) {
+      error = "bad vertex " + to_string(v);
+      return false;
+    }
+    mesh.x[v] = (Real)x;
+    mesh.y[v] = (Real)y;
+    r.skip_line();
+  }
+  mesh.corners.clear();
+  mesh.corners.reserve(faces * 3);
+  for (size_t f = 0; f < faces; ++f) {
+    size_t n = 0;
+    uint32_t first = 0, previous = 0;
+    if (!r.next_line() || !r.field(n) || n < 3) {
+      error = "bad face " + to_string(f);
+      return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t corner;
+      if (!r.field(corner) || corner >= vertices) {
+        error = "bad face " + to_string(f);
+        return false;
+      }
+      if (i == 0) {
+        first = corner;
+      } else if (i >= 2) {
+        mesh.corners.push_back(first);
+        mesh.corners.push_back(previous);
+        mesh.corners.push_back(corner);
+      }
+      previous = corner;
+    }
+    r.skip_line();
+  }
+  return true;
+}
+
+double seconds_since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template <class Real>
+int run_mesh(const char* path, unsigned threads) {
+  Mesh<Real> mesh;
+  string error;
+  if (!load_off(path, mesh, error)) {
+    cerr << "Error: " << error << endl;
+    return 1;
+  }
+  size_t n = mesh.triangles();
+  vector<Real> area(n);
+  ThreadPool pool(threads);
+  auto start = chrono::steady_clock::now();
+  triangle_areas(pool, mesh.x.data(), mesh.y.data(), mesh.corners.data(), n, area.data());
+  double secs = seconds_since(start);
+
+  double total = 0;
+  size_t turns[3] = {0, 0, 0}; // clockwise, degenerate, counterclockwise
+  for (size_t t = 0; t < n; ++t) {
+    total += fabs((double)area[t]);
+    ++turns[orientation(area[t]) + 1];
+  }
+  cout << "Triangles:        " << n << endl;
+  cout << "Total area:       " << total << endl;
+  cout << "Counterclockwise: " << turns[2] << endl;
+  cout << "Clockwise:        " << turns[0] << endl;
+  cout << "Degenerate:       " << turns[1] << endl;
+  cout << "Computed in " << secs << " s, " << n / max(secs, 1e-9) / 1e6 << " M triangles/s on " << pool.size()
+       << " threads" << endl;
+  return 0;
+}
+
+// best of a few runs of fn, in triangles/s
+template <class F>
+double best_rate(size_t triangles, F fn) {
+  double best = HUGE_VAL;
+  for (int run = 0; run < 5; ++run) {
+    auto start = chrono::steady_clock::now();
+    fn();
+    best = min(best, seconds_since(start));
+  }
+  return triangles / best;
+}
+
+// Strips of triangles over a random point cloud, neighbours sharing
+// vertices the way mesh triangles do
+template <class Real>
+void make_mesh(size_t triangles, Mesh<Real>& mesh) {
+  mt19937 rng(114);
+  uniform_real_distribution<double> coord(-1000, 1000);
+  size_t vertices = triangles / 2 + 16;
+  for (size_t v = 0; v < vertices; ++v) {
+    mesh.x.push_back((Real)coord(rng));
+    mesh.y.push_back((Real)coord(rng));
+  }
+  for (size_t t = 0; t < triangles; ++t) {
+    uint32_t base = t / 2;
+    mesh.corners.push_back(base);
+    mesh.corners.push_back(base + 1 + rng() % 8);
+    mesh.corners.push_back(base + 1 + rng() % 15);
+  }
+}
+
+template <class Real>
+int bench_precision(const char* name, size_t triangles, unsigned max_threads) {
+  Mesh<Real> mesh;
+  make_mesh(triangles, mesh);
+  const Real* x = mesh.x.data();
+  const Real* y = mesh.y.data();
+  const uint32_t* c = mesh.corners.data();
+  vector<Real> reference(triangles), area(triangles);
+  triangle_areas(x, y, c, triangles, reference.data());
+
+  int status = 0;
+  for (unsigned threads = 1; ; threads = min(threads * 2, max_threads)) {
+    ThreadPool pool(threads);
+    fill(area.begin(), area.end(), Real(0));
+    double rate = best_rate(triangles, [&]() { triangle_areas(pool, x, y, c, triangles, area.data()); });
+    cout << name << setw(4) << threads << " threads " << setw(8) << fixed << setprecision(1) << rate / 1e6
+         << " M triangles/s" << endl;
+    if (memcmp(reference.data(), area.data(), triangles * sizeof(Real)) != 0) {
+      cerr << "Error: " << name << " areas on " << threads << " threads differ from one" << endl;
+      status = 1;
+    }
+    if (threads >= max_threads) {
+      break;
+    }
+  }
+  return status;
+}
+
+int bench(size_t triangles, unsigned max_threads) {
+  cout << triangles << " triangles" << endl;
+  int status = bench_precision<double>("double", triangles, max_threads);
+  return bench_precision<float>("float ", triangles, max_threads) | status;
+}
+
+int main(int argc, char* argv[]) {
+  string mode = argc > 1 ? argv[1] : "";
+  unsigned cores = max(1u, thread::hardware_concurrency());
+  if (mode == "mesh") {
+    if (argc < 3) {
+      cerr << "Error: no mesh file" << endl;
+      return 1;
+    }
+    // a thread count and "float", in any order
+    unsigned threads = cores;
+    bool single = false;
+    for (int i = 3; i < argc; ++i) {
+      string arg = argv[i];
+      if (arg == "float") {
+        single = true;
+      } else if (!arg.empty() && arg.find_first_not_of("0123456789") == string::npos) {
+        threads = (unsigned)max(1ul, min(strtoul(arg.c_str(), NULL, 10), 4096ul));
+      } else {
+        cerr << "Error: unknown option " << arg << endl;
+        return 1;
+      }
+    }
+    return single ? run_mesh<float>(argv[2], threads) : run_mesh<double>(argv[2], threads);
+  }
+  if (mode == "bench") {
+    return bench(argc > 2 ? strtoul(argv[2], NULL, 10) : 4000000, argc > 3 ? max(1, atoi(argv[3])) : cores);
+  }
+
+  run_interactive();
+  return 0;
+}
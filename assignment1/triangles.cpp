@@ -0,0 +1,29 @@
+#include "triangles.h"
+
+// triangles per chunk handed to a pool thread
+static const size_t AREA_GRAIN = 1 << 16;
+
+template <class Real>
+void triangle_areas(const Real* x, const Real* y, const uint32_t* corners, size_t count, Real* area) {
+  for (size_t t = 0; t < count; ++t) {
+    const uint32_t* c = corners + 3 * t;
+    Real ux = x[c[1]] - x[c[0]], uy = y[c[1]] - y[c[0]];
+    Real vx = x[c[2]] - x[c[0]], vy = y[c[2]] - y[c[0]];
+    area[t] = (ux * vy - vx * uy) * Real(0.5);
+  }
+}
+
+template <class Real>
+void triangle_areas(ThreadPool& pool, const Real* x, const Real* y, const uint32_t* corners, size_t count,
+                    Real* area) {
+  pool.parallelFor(0, count, AREA_GRAIN, [&](size_t begin, size_t end) {
+    triangle_areas(x, y, corners + 3 * begin, end - begin, area + begin);
+  });
+}
+
+#define INSTANTIATE(Real)                                                                                       \
+  template void triangle_areas<Real>(const Real*, const Real*, const uint32_t*, size_t, Real*);               \
+  template void triangle_areas<Real>(ThreadPool&, const Real*, const Real*, const uint32_t*, size_t, Real*);
+
+INSTANTIATE(float)
+INSTANTIATE(double)
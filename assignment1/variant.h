@@ -0,0 +1,91 @@
+#ifndef __VARIANT_H__
+#define __VARIANT_H__
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "feedback.h"
+
+// The feedback engine for any word length from 4 to 8 letters. Words are
+// packed like PackedWord, 5 bits per letter, and patterns are base 3 with
+// letter i weighing 3^i; only the integer widths change with the length.
+// The length is a template argument, so every loop has a constant trip
+// count, and the 5 letter case is the hand written score_guess() itself.
+
+const int MIN_WORD_LENGTH = 4;
+const int MAX_WORD_LENGTH = 8;
+
+constexpr int pow3(int n) {
+  return n == 0 ? 1 : 3 * pow3(n - 1);
+}
+
+template <int N>
+struct WordShape {
+  static_assert(N >= MIN_WORD_LENGTH && N <= MAX_WORD_LENGTH, "words are 4 to 8 letters");
+  typedef typename std::conditional<5 * N <= 32, uint32_t, uint64_t>::type Packed;
+  static const int PATTERNS = pow3(N);
+  static const int ALL_GREEN = PATTERNS - 1;
+};
+
+template <int N>
+inline int word_letter_n(typename WordShape<N>::Packed word, int i) {
+  return (int)((word >> (5 * i)) & 31);
+}
+
+// false unless word is exactly N letters (either case)
+template <int N>
+bool pack_word_n(const char* word, size_t len, typename WordShape<N>::Packed& packed) {
+  if (len != (size_t)N) {
+    return false;
+  }
+  packed = 0;
+  for (int i = 0; i < N; ++i) {
+    char c = word[i] | 0x20; // lowercase
+    if (c < 'a' || c > 'z') {
+      return false;
+    }
+    packed |= (typename WordShape<N>::Packed)(c - 'a') << (5 * i);
+  }
+  return true;
+}
+
+template <int N>
+std::string unpack_word_n(typename WordShape<N>::Packed word) {
+  std::string s(N, ' ');
+  for (int i = 0; i < N; ++i) {
+    s[i] = 'a' + word_letter_n<N>(word, i);
+  }
+  return s;
+}
+
+// same rules as score_guess()
+template <int N>
+int score_guess_n(typename WordShape<N>::Packed guess, typename WordShape<N>::Packed answer) {
+  uint8_t unmatched[32] = {0};
+  int pattern = 0;
+  typename WordShape<N>::Packed diff = guess ^ answer;
+#pragma GCC unroll 8
+  for (int i = 0, weight = 1; i < N; ++i, weight *= 3) {
+    if ((diff >> (5 * i)) & 31) {
+      ++unmatched[word_letter_n<N>(answer, i)];
+    } else {
+      pattern += FEEDBACK_GREEN * weight;
+    }
+  }
+#pragma GCC unroll 8
+  for (int i = 0, weight = 1; i < N; ++i, weight *= 3) {
+    int g = word_letter_n<N>(guess, i);
+    if (((diff >> (5 * i)) & 31) && unmatched[g]) {
+      --unmatched[g];
+      pattern += FEEDBACK_YELLOW * weight;
+    }
+  }
+  return pattern;
+}
+
+template <>
+inline int score_guess_n<5>(uint32_t guess, uint32_t answer) {
+  return score_guess(guess, answer);
+}
+
+#endif
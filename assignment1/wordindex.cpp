@@ -0,0 +1,35 @@
+#include "wordindex.h"
+
+using namespace std;
+
+void WordIndex::build(const vector<string>& words) {
+  vector<PackedWord> packed;
+  packed.reserve(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    PackedWord w;
+    if (pack_word(words[i], w)) {
+      packed.push_back(w);
+    }
+  }
+  build(packed);
+}
+
+void WordIndex::build(const vector<PackedWord>& words) {
+  int bits = 4;
+  while ((size_t)1 << bits < 2 * words.size()) {
+    ++bits;
+  }
+  m_shift = 32 - bits;
+  m_slots.assign((size_t)1 << bits, 0);
+  m_size = 0;
+  for (size_t i = 0; i < words.size(); ++i) {
+    size_t s = slot(words[i]);
+    while (m_slots[s] != 0 && m_slots[s] != words[i] + 1) {
+      s = (s + 1) & (m_slots.size() - 1);
+    }
+    if (m_slots[s] == 0) {
+      m_slots[s] = words[i] + 1;
+      ++m_size;
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef __WORDINDEX_H__
+#define __WORDINDEX_H__
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "feedback.h"
+
+// Set of 5 letter words for validating guesses. Words are stored as packed
+// keys in an open addressing table (linear probing, at most half full), so
+// a lookup packs the word in registers and usually touches one cache line;
+// nothing is allocated after build().
+class WordIndex {
+public:
+  WordIndex() : m_shift(28), m_size(0) {}
+
+  // words that don't pack (wrong length, not letters) are skipped
+  void build(const std::vector<std::string>& words);
+  void build(const std::vector<PackedWord>& words);
+
+  bool contains(PackedWord word) const {
+    PackedWord key = word + 1; // 0 marks an empty slot
+    if (m_slots.empty()) {
+      return false;
+    }
+    for (size_t i = slot(word); ; i = (i + 1) & (m_slots.size() - 1)) {
+      if (m_slots[i] == key) {
+        return true;
+      }
+      if (m_slots[i] == 0) {
+        return false;
+      }
+    }
+  }
+  // case-insensitive, like the word list
+  bool contains(const std::string& word) const {
+    PackedWord w;
+    return pack_word(word, w) && contains(w);
+  }
+  size_t size() const { return m_size; }
+
+private:
+  size_t slot(PackedWord word) const { return (uint32_t)(word * 0x9E3779B1u) >> m_shift; }
+
+  std::vector<PackedWord> m_slots;
+  int m_shift; // 32 - log2(slots)
+  size_t m_size;
+};
+
+#endif
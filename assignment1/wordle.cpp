@@ -2,36 +2,78 @@
 #include <vector>
 #include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <cstdlib>
 #include <ctime>
 #include <string>
 #include <cctype>
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <memory>
+#include <functional>
+#include "feedback.h"
+#include "solver.h"
+#include "wordindex.h"
+#include "wordlist.h"
+#include "game.h"
+#include "server.h"
+#include "render.h"
+#include "simulate.h"
+#include "candidates.h"
+#include "variant.h"
+#include "multiboard.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
-const string GREEN = "\033[92m";
-const string YELLOW = "\033[93m";
-const string COLOR_OFF = "\033[0m";
-
-// declaration for play_game (needed for ask_for_new_game)
-void play_game(const vector<string>& word_list);
-
-struct Cell {
-  char letter;
-  string color;
-
-  Cell() : letter('*'), color(COLOR_OFF) {}
-
-  Cell(char l, string c) : letter(l), color(c) {}
-};
-
-void print_board(const vector<vector<Cell> >& board) {
-  for (size_t i = 0; i < board.size(); ++i) {
-    for (size_t j = 0; j < board[i].size(); ++j) {
-      cout << board[i][j].color << board[i][j].letter << COLOR_OFF;
-    }
-    cout << endl;
-  }
+// g++ -std=c++17 -O2 wordle.cpp feedback.cpp solver.cpp wordindex.cpp wordlist.cpp game.cpp server.cpp render.cpp simulate.cpp candidates.cpp multiboard.cpp threadpool.cpp -pthread -o wordle
+//
+//   ./wordle                  play a game
+//   ./wordle table [file]     precompute every guess x answer feedback
+//                             pattern for wordlist.txt into file
+//                             (patterns.bin by default)
+//   ./wordle solve [word]     let the entropy solver play word, or every
+//                             word in the list and report guesses/s and depth;
+//                             uses patterns.bin if it is there
+//   ./wordle lookups          guess validation lookups/s, binary search
+//                             over strings against WordIndex
+//   ./wordle snapshot         write wordlist.bin, which later runs map
+//                             instead of parsing wordlist.txt
+//   ./wordle startup          time each way of loading the word list
+//   ./wordle serve [socket]   game server speaking the protocol in server.h
+//                             on stdin/stdout, or on a Unix socket
+//   ./wordle loadgen [games] [concurrent] [socket]
+//                             play games through the protocol, in process
+//                             or against a server's socket, and report
+//                             games/s and guess latency
+//   ./wordle simulate [strategy] [games] [seed]
+//                             play every word (or a seeded sample of games
+//                             words) with strategy: entropy (default),
+//                             random or first candidate, in parallel, and
+//                             report the depth distribution and speed
+//   ./wordle filter           words/s narrowing the list after a guess,
+//                             score_guess per word against CandidateSet
+//   ./wordle multi [boards] [length] [file]
+//                             play 1 to 16 boards at once (4 by default,
+//                             Quordle) with words of 4 to 8 letters from
+//                             file (wordlist.txt)
+//   ./wordle boards           ns per guess scored against 1 to 16 boards,
+//                             board by board against shared scoring
+//   ./wordle render [games]   replay random games and time drawing their
+//                             boards, cout per cell against BoardRenderer
+//
+// Boards are colored when stdout is a terminal, unless NO_COLOR is set.
+
+// games a server can host at once
+const size_t SERVER_CAPACITY = 1 << 20;
+
+// writes whatever the renderer has behind anything still buffered in cout
+void show(BoardRenderer& out) {
+  cout.flush();
+  out.flush(STDOUT_FILENO);
 }
 
 string to_lowercase(const string& str) {
@@ -53,114 +95,664 @@ vector<string> read_word_list(const string& filename) {
 
   string word;
   while (getline(file, word)) {
-    string lower_word = to_lowercase(word);
-    word_list.push_back(word);
+    word_list.push_back(to_lowercase(word));
   }
 
   file.close();
   return word_list;
 }
 
-bool is_valid_word(const string& word, const vector<string>& word_list) {
-  string lower_word = to_lowercase(word);
-  return binary_search(word_list.begin(), word_list.end(), lower_word);
+bool is_valid_word(const string& word, const WordIndex& index) {
+  return index.contains(word);
 }
 
 
-void update_board(vector<vector<Cell> >& board, const string& guess, const string& target, int attempt) {
-  for (size_t i = 0; i < guess.length(); ++i) {
-    if (guess[i] == target[i]) {
-      board[attempt][i] = Cell(guess[i], GREEN);
-    } else if (target.find(guess[i]) != string::npos) {
-      board[attempt][i] = Cell(guess[i], YELLOW);
-    } else {
-      board[attempt][i] = Cell(guess[i], COLOR_OFF);
-    }
-  }
-}
-
-void print_word_in_green(const string& word) {
-  for (size_t i = 0; i < word.length(); ++i) {
-    cout << GREEN << word[i] << COLOR_OFF;
-  }
-  cout << endl;
-}
-
-void ask_for_new_game(const vector<string>& word_list) {
+bool ask_for_new_game() {
   string input;
   while (true) {
     cout << "Do you want to start a new game (y/n)? ";
-    cin >> input;
+    if (!(cin >> input)) {
+      return false;
+    }
     if (input == "y" || input == "Y") {
-      play_game(word_list);
-      break;
+      return true;
     } else if (input == "n" || input == "N") {
       cout << "Thanks for playing!" << endl;
-      exit(0);
+      return false;
     } else {
       cout << "Invalid input. Please enter 'y' or 'n'." << endl;
     }
   }
 }
 
-void play_game(const vector<string>& word_list) {
-  string target_word = word_list[rand() % word_list.size()];
+// plays one game, returns whether the player wants another
+bool play_game(const WordList& words, const WordIndex& index) {
+  BoardRenderer out(stdout_wants_color());
+  GameSession game;
+  game.start(words[rand() % words.size()]);
+  string target_word = unpack_word(game.target);
 
 #ifndef DEBUG
   cout << "Target word: " << target_word << endl;
 #endif
 
-  vector<vector<Cell> > board(6, vector<Cell>(5));
-
-  for (int attempt = 0; attempt < 6; ++attempt) {
-    print_board(board);
+  while (game.state == GAME_PLAYING) {
+    out.board(game);
+    show(out);
 
     cout << "Enter your guess: ";
     string guess;
-    cin >> guess;
-
-    if (guess == "quit") {
+    if (!(cin >> guess) || guess == "quit") {
       cout << "Thanks for playing!" << endl;
-      return;
+      return false;
     } else if (guess == "new") {
       cout << "Starting a new game..." << endl;
-      play_game(word_list);
-      return;
-    } else if (guess.length() != 5 || !is_valid_word(guess, word_list)) {
+      return true;
+    }
+    PackedWord word;
+    if (!pack_word(guess, word) || !index.contains(word)) {
+      cout << "Invalid word, please try again." << endl;
+      continue;
+    }
+    game.guess(word);
+  }
+
+  out.board(game);
+  if (game.state == GAME_WON) {
+    out.text("Congratulations, you've guessed the word! The word was: ");
+  } else {
+    out.text("Sorry, you've used all attempts. The correct word was: ");
+  }
+  out.word(target_word, FEEDBACK_GREEN);
+  out.text("\n", 1);
+  show(out);
+  return ask_for_new_game();
+}
+
+double seconds_since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int build_table(const WordList& word_list, const string& path) {
+  vector<PackedWord> words(word_list.begin(), word_list.end());
+  PatternTable table;
+  auto start = chrono::steady_clock::now();
+  table.build(words, words);
+  double secs = seconds_since(start);
+  if (!table.save(path)) {
+    cerr << "Error: Could not write " << path << endl;
+    return 1;
+  }
+  cout << words.size() << " x " << words.size() << " patterns in " << secs << " s ("
+       << words.size() * (double)words.size() / secs / 1e6 << " M pairs/s), saved to " << path << endl;
+
+  start = chrono::steady_clock::now();
+  PatternTable mapped;
+  if (!mapped.load(path)) {
+    cerr << "Error: Could not load " << path << endl;
+    return 1;
+  }
+  cout << "mapped back in " << seconds_since(start) * 1e3 << " ms" << endl;
+  return 0;
+}
+
+// maps patterns.bin when it matches the word list, builds the table otherwise
+void load_table(const vector<PackedWord>& words, PatternTable& table) {
+  if (table.load("patterns.bin") && table.num_guesses() == words.size() && table.num_answers() == words.size() &&
+      equal(words.begin(), words.end(), table.guesses())) {
+    return;
+  }
+  table.build(words, words);
+}
+
+int run_solver(const WordList& word_list, const string& target) {
+  vector<PackedWord> words(word_list.begin(), word_list.end());
+  PatternTable table;
+  auto start = chrono::steady_clock::now();
+  load_table(words, table);
+  cout << "pattern table ready in " << seconds_since(start) << " s" << endl;
+
+  ThreadPool pool(thread::hardware_concurrency());
+  EntropySolver solver(table, &pool);
+
+  if (!target.empty()) {
+    PackedWord t;
+    const PackedWord* found = pack_word(target, t) ? find(table.answers(), table.answers() + table.num_answers(), t) : NULL;
+    if (!found || found == table.answers() + table.num_answers()) {
+      cerr << "Error: " << target << " is not in the word list" << endl;
+      return 1;
+    }
+    vector<size_t> path;
+    int depth = solver.solve(found - table.answers(), &path);
+    for (size_t i = 0; i < path.size(); ++i) {
+      cout << unpack_word(table.guesses()[path[i]]) << endl;
+    }
+    cout << "solved in " << depth << endl;
+    return 0;
+  }
+
+  vector<int> depths(10, 0);
+  int total = 0;
+  start = chrono::steady_clock::now();
+  for (size_t a = 0; a < table.num_answers(); ++a) {
+    int depth = solver.solve(a);
+    total += depth;
+    ++depths[min(depth, 9)];
+  }
+  double secs = seconds_since(start);
+
+  size_t n = table.num_answers();
+  // every guess played counts, cached ones included; the pairs scored are
+  // the work behind the uncached ones
+  cout << n << " words in " << secs << " s, average depth " << (double)total / n << ", "
+       << total / secs << " guesses/s (" << solver.pairs_scored() / secs / 1e6 << " M guess x candidate pairs/s)"
+       << endl;
+  for (int d = 1; d < 10; ++d) {
+    if (depths[d]) {
+      cout << (d == 9 ? "9+" : to_string(d)) << ": " << depths[d] << endl;
+    }
+  }
+  return 0;
+}
+
+// the old validation path, kept for comparison
+bool is_valid_word_sorted(const string& word, const vector<string>& word_list) {
+  string lower_word = to_lowercase(word);
+  return binary_search(word_list.begin(), word_list.end(), lower_word);
+}
+
+int bench_lookups(const WordList& words) {
+  vector<string> word_list;
+  for (size_t i = 0; i < words.size(); ++i) {
+    word_list.push_back(words.word(i));
+  }
+  auto start = chrono::steady_clock::now();
+  WordIndex index;
+  index.build(vector<PackedWord>(words.begin(), words.end()));
+  cout << index.size() << " words indexed in " << seconds_since(start) * 1e3 << " ms" << endl;
+
+  // every word once and as many misses, mixed case like typed guesses
+  vector<string> queries;
+  for (size_t i = 0; i < word_list.size(); ++i) {
+    string w = word_list[i];
+    w[0] = toupper(w[0]);
+    queries.push_back(w);
+    swap(w[1], w[4]);
+    queries.push_back(w);
+  }
+  shuffle(queries.begin(), queries.end(), mt19937(114));
+
+  const int reps = 50;
+  size_t found[2] = {0, 0};
+  double secs[2];
+  for (int method = 0; method < 2; ++method) {
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      for (size_t i = 0; i < queries.size(); ++i) {
+        found[method] += method == 0 ? is_valid_word_sorted(queries[i], word_list) : is_valid_word(queries[i], index);
+      }
+    }
+    secs[method] = seconds_since(start);
+  }
+  double lookups = (double)reps * queries.size();
+  cout << "binary_search: " << lookups / secs[0] / 1e6 << " M lookups/s" << endl;
+  cout << "WordIndex:     " << lookups / secs[1] / 1e6 << " M lookups/s ("
+       << secs[0] / secs[1] << "x)" << endl;
+  if (found[0] != found[1]) {
+    cerr << "Error: the two paths disagree" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+time_t modified(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? st.st_mtime : 0;
+}
+
+// wordlist.bin unless wordlist.txt has changed since it was written
+void load_words(WordList& words) {
+  if (modified("wordlist.bin") >= modified("wordlist.txt") && words.load_snapshot("wordlist.bin")) {
+    return;
+  }
+  if (!words.load_text("wordlist.txt")) {
+    cerr << "Error: Could not open the file wordlist.txt" << endl;
+    exit(1);
+  }
+}
+
+int bench_startup() {
+  const int reps = 20;
+  double secs[3];
+  size_t sizes[3];
+  for (int method = 0; method < 3; ++method) {
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      if (method == 0) {
+        vector<string> word_list = read_word_list("wordlist.txt");
+        sort(word_list.begin(), word_list.end());
+        sizes[method] = word_list.size();
+      } else {
+        WordList words;
+        if (!(method == 1 ? words.load_text("wordlist.txt") : words.load_snapshot("wordlist.bin"))) {
+          cerr << "Error: Could not load " << (method == 1 ? "wordlist.txt" : "wordlist.bin (run ./wordle snapshot)") << endl;
+          return 1;
+        }
+        sizes[method] = words.size();
+      }
+    }
+    secs[method] = seconds_since(start) / reps;
+  }
+  const char* names[3] = {"getline + sort", "mapped text   ", "snapshot      "};
+  for (int method = 0; method < 3; ++method) {
+    cout << names[method] << setw(10) << secs[method] * 1e6 << " us  " << sizes[method] << " words" << endl;
+  }
+  return 0;
+}
+
+// the N letter words of a text file, sorted (by packed value) and unique
+template <int N>
+vector<typename WordShape<N>::Packed> read_words_n(const string& path) {
+  vector<typename WordShape<N>::Packed> words;
+  ifstream file(path);
+  string line;
+  while (getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    typename WordShape<N>::Packed w;
+    if (pack_word_n<N>(line.data(), line.size(), w)) {
+      words.push_back(w);
+    }
+  }
+  sort(words.begin(), words.end());
+  words.erase(unique(words.begin(), words.end()), words.end());
+  return words;
+}
+
+// several boards of N letter words played with the same guesses
+template <int N>
+int play_multi(int boards, const string& path) {
+  typedef typename WordShape<N>::Packed Packed;
+  vector<Packed> words = read_words_n<N>(path);
+  if (words.size() < (size_t)boards) {
+    cerr << "Error: " << path << " has " << words.size() << " words of " << N << " letters, "
+         << boards << " needed" << endl;
+    return 1;
+  }
+  mt19937 rng((unsigned)time(0));
+  vector<Packed> answers(words);
+  shuffle(answers.begin(), answers.end(), rng);
+  MultiBoard<N> game;
+  game.start(answers.data(), boards);
+
+  cout << boards << " boards of " << N << " letter words, " << game.max_attempts() << " guesses" << endl;
+  int patterns[MAX_BOARDS];
+  while (!game.over()) {
+    cout << "Guess " << game.attempts() + 1 << " (" << game.solved_count() << "/" << boards << " solved): ";
+    string guess;
+    if (!(cin >> guess) || guess == "quit") {
+      break;
+    }
+    Packed word;
+    if (!pack_word_n<N>(guess.data(), guess.size(), word) || !binary_search(words.begin(), words.end(), word)) {
       cout << "Invalid word, please try again." << endl;
-      --attempt;
       continue;
     }
+    uint32_t was_solved = 0;
+    for (int b = 0; b < boards; ++b) {
+      was_solved |= (uint32_t)game.solved(b) << b;
+    }
+    game.guess(word, patterns);
+    for (int b = 0; b < boards; ++b) {
+      if ((was_solved >> b) & 1) {
+        continue;
+      }
+      string feedback(N, '.');
+      for (int i = 0, p = patterns[b]; i < N; ++i, p /= 3) {
+        feedback[i] = ".YG"[p % 3];
+      }
+      cout << setw(4) << b + 1 << ": " << unpack_word_n<N>(word) << " " << feedback
+           << (game.solved(b) ? " solved" : "") << endl;
+    }
+  }
+  cout << (game.won() ? "You solved every board! The words were:" : "The words were:");
+  for (int b = 0; b < boards; ++b) {
+    cout << " " << unpack_word_n<N>(game.answer(b));
+  }
+  cout << endl;
+  return 0;
+}
+
+int run_multi(int boards, int length, const string& path) {
+  if (boards < 1 || boards > MAX_BOARDS) {
+    cerr << "Error: 1 to " << MAX_BOARDS << " boards" << endl;
+    return 1;
+  }
+  switch (length) {
+  case 4: return play_multi<4>(boards, path);
+  case 5: return play_multi<5>(boards, path);
+  case 6: return play_multi<6>(boards, path);
+  case 7: return play_multi<7>(boards, path);
+  case 8: return play_multi<8>(boards, path);
+  }
+  cerr << "Error: words are " << MIN_WORD_LENGTH << " to " << MAX_WORD_LENGTH << " letters" << endl;
+  return 1;
+}
+
+// guesses scored against every board, one board at a time with
+// score_guess_n() against score_boards(), on random words
+template <int N>
+void bench_boards_n() {
+  typedef typename WordShape<N>::Packed Packed;
+  mt19937 rng(114);
+  auto random_word = [&]() {
+    Packed w = 0;
+    for (int i = 0; i < N; ++i) {
+      w |= (Packed)(rng() % 26) << (5 * i);
+    }
+    return w;
+  };
+  const int guesses = 1 << 20;
+  vector<Packed> guess(guesses);
+  for (int g = 0; g < guesses; ++g) {
+    guess[g] = random_word();
+  }
+  const int counts[4] = {1, 4, 8, 16};
+  for (int c = 0; c < 4; ++c) {
+    int boards = counts[c];
+    Packed answers[MAX_BOARDS];
+    for (int b = 0; b < boards; ++b) {
+      answers[b] = random_word();
+    }
+    MultiBoard<N> game;
+    game.start(answers, boards, guesses);
+    int patterns[MAX_BOARDS];
+    long check[2] = {0, 0};
+    double secs[2];
+    for (int method = 0; method < 2; ++method) {
+      auto start = chrono::steady_clock::now();
+      for (int g = 0; g < guesses; ++g) {
+        if (method == 0) {
+          for (int b = 0; b < boards; ++b) {
+            patterns[b] = score_guess_n<N>(guess[g], answers[b]);
+          }
+        } else {
+          game.guess(guess[g], patterns);
+        }
+        for (int b = 0; b < boards; ++b) {
+          check[method] += patterns[b];
+        }
+      }
+      secs[method] = seconds_since(start);
+    }
+    cout << N << " letters " << setw(2) << boards << " boards: per board " << setw(7) << secs[0] / guesses * 1e9
+         << " ns/guess, shared " << setw(7) << secs[1] / guesses * 1e9 << " ns/guess"
+         << (check[0] != check[1] ? "  MISMATCH" : "") << endl;
+  }
+}
 
-    update_board(board, guess, target_word, attempt);
+int bench_boards() {
+  bench_boards_n<4>();
+  bench_boards_n<5>();
+  bench_boards_n<6>();
+  bench_boards_n<7>();
+  bench_boards_n<8>();
+  return 0;
+}
 
-    if (guess == target_word) {
-      print_board(board);
-      cout << "Congratulations, you've guessed the word! The word was: ";
-      print_word_in_green(target_word);
+// narrowing the full list after one guess: score_guess() per word against
+// CandidateSet, scalar and AVX2
+int bench_filter(const WordList& words) {
+  mt19937 rng(114);
+  uniform_int_distribution<size_t> pick(0, words.size() - 1);
+  const int reps = 200;
+  vector<pair<PackedWord, int> > queries;
+  for (int r = 0; r < reps; ++r) {
+    PackedWord guess = words[pick(rng)];
+    queries.push_back(make_pair(guess, score_guess(guess, words[pick(rng)])));
+  }
 
-      ask_for_new_game(word_list);
-      return;
+  CandidateSet all;
+  all.assign(words.begin(), words.size());
+  const char* names[3] = {"score_guess      ", "CandidateSet     ", "CandidateSet AVX2"};
+  size_t kept[3] = {0, 0, 0};
+  double secs[3];
+  vector<uint32_t> left;
+  CandidateSet candidates;
+  for (int method = 0; method < 3; ++method) {
+    candidates.set_simd(method == 2);
+    if (method == 2 && !candidates.simd()) {
+      cout << names[2] << " (no AVX2 on this CPU)" << endl;
+      break;
+    }
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      if (method == 0) {
+        left.clear();
+        for (size_t i = 0; i < words.size(); ++i) {
+          if (score_guess(queries[r].first, words[i]) == queries[r].second) {
+            left.push_back((uint32_t)i);
+          }
+        }
+        kept[method] += left.size();
+      } else {
+        kept[method] += candidates.filter_from(all, queries[r].first, queries[r].second);
+      }
+    }
+    secs[method] = seconds_since(start);
+    cout << names[method] << setw(10) << reps * words.size() / secs[method] / 1e6 << " M words/s ("
+         << secs[0] / secs[method] << "x)" << endl;
+    if (kept[method] != kept[0]) {
+      cerr << "Error: " << names[method] << " kept " << kept[method] << " words, not " << kept[0] << endl;
+      return 1;
+    }
+    // untimed: the same words in the same order, not just as many
+    for (int r = 0; method > 0 && r < reps; ++r) {
+      left.clear();
+      for (size_t i = 0; i < words.size(); ++i) {
+        if (score_guess(queries[r].first, words[i]) == queries[r].second) {
+          left.push_back((uint32_t)i);
+        }
+      }
+      candidates.filter_from(all, queries[r].first, queries[r].second);
+      if (candidates.ids() != left) {
+        cerr << "Error: " << names[method] << " kept the wrong words after " << unpack_word(queries[r].first)
+             << endl;
+        return 1;
+      }
     }
   }
+  return 0;
+}
 
-  // out of attempts
-  print_board(board);
-  cout << "Sorry, you've used all attempts. The correct word was: " << GREEN << target_word << COLOR_OFF << endl;
+int run_simulation(const WordList& word_list, const string& name, size_t games, uint64_t seed) {
+  PatternTable table;
+  unique_ptr<Strategy> strategy;
+  auto start = chrono::steady_clock::now();
+  if (name == "entropy") {
+    load_table(vector<PackedWord>(word_list.begin(), word_list.end()), table);
+    strategy.reset(new EntropyStrategy(table));
+    cout << "pattern table and opening guess ready in " << seconds_since(start) << " s" << endl;
+  } else if (name == "random") {
+    strategy.reset(new RandomCandidateStrategy());
+  } else if (name == "first") {
+    strategy.reset(new FirstCandidateStrategy());
+  } else {
+    cerr << "Error: unknown strategy " << name << " (entropy, random or first)" << endl;
+    return 1;
+  }
+
+  ThreadPool pool(thread::hardware_concurrency());
+  vector<uint32_t> targets = sample_targets(word_list.size(), games, seed);
+  SimulationResult result = simulate(word_list, targets, *strategy, pool, seed);
+
+  size_t solved = result.games - result.failed;
+  size_t solved_guesses = 0;
+  for (int d = 1; d <= MAX_ATTEMPTS; ++d) {
+    solved_guesses += d * result.depths[d];
+  }
+  cout << strategy->name() << ": " << result.games << " games on " << pool.size() << " threads in "
+       << result.seconds << " s, " << result.games / result.seconds << " games/s, "
+       << result.guesses / result.seconds << " guesses/s" << endl;
+  cout << "average depth " << (solved ? (double)solved_guesses / solved : 0) << " when solved, "
+       << result.failed << " failed (" << 100.0 * result.failed / result.games << "%)" << endl;
+  for (int d = 1; d <= MAX_ATTEMPTS; ++d) {
+    cout << d << ": " << result.depths[d] << endl;
+  }
+  cout << "X: " << result.failed << endl;
+  return 0;
+}
 
-  ask_for_new_game(word_list);
+// the old way: every escape and letter its own cout <<, endl per row
+void print_board_cout(ostream& out, const GameSession& game) {
+  const string colors[3] = {"\033[0m", "\033[93m", "\033[92m"};
+  for (int i = 0; i < MAX_ATTEMPTS; ++i) {
+    for (int j = 0; j < WORD_LENGTH; ++j) {
+      if (i >= game.attempts) {
+        out << colors[0] << '*' << colors[0];
+      } else {
+        out << colors[pattern_digit(game.patterns[i], j)] << (char)('a' + word_letter(game.guesses[i], j)) << colors[0];
+      }
+    }
+    out << endl;
+  }
+}
+
+int bench_render(const WordList& words, size_t games) {
+  // random targets and guesses, so boards have every mix of colors and
+  // of rows played
+  mt19937 rng(114);
+  uniform_int_distribution<size_t> pick(0, words.size() - 1);
+  vector<GameSession> replay(games);
+  for (size_t g = 0; g < games; ++g) {
+    replay[g].start(words[pick(rng)]);
+    for (int a = rng() % (MAX_ATTEMPTS + 1); a > 0 && replay[g].state == GAME_PLAYING; --a) {
+      replay[g].guess(words[pick(rng)]);
+    }
+  }
+
+  int fd = open("/dev/null", O_WRONLY);
+  ofstream null_stream("/dev/null");
+  if (fd < 0 || !null_stream) {
+    cerr << "Error: Could not open /dev/null" << endl;
+    return 1;
+  }
+  const char* names[4] = {"cout per cell        ", "renderer, per board  ", "renderer, batched    ", "renderer plain, batch"};
+  for (int method = 0; method < 4; ++method) {
+    BoardRenderer out(method != 3);
+    size_t bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t g = 0; g < games; ++g) {
+      if (method == 0) {
+        print_board_cout(null_stream, replay[g]);
+        continue;
+      }
+      out.board(replay[g]);
+      if (method == 1 || out.size() >= (1 << 16) - 256) {
+        bytes += out.size();
+        out.flush(fd);
+      }
+    }
+    bytes += out.size();
+    out.flush(fd);
+    double secs = seconds_since(start);
+    if (method == 0) {
+      // /dev/null doesn't count, so render again just to measure
+      ostringstream counter;
+      for (size_t g = 0; g < games; ++g) {
+        print_board_cout(counter, replay[g]);
+        bytes += counter.tellp();
+        counter.str("");
+      }
+    }
+    cout << names[method] << setw(10) << games / secs / 1e6 << " M boards/s " << setw(8) << bytes / secs / 1e6
+         << " MB/s " << setw(6) << (double)bytes / games << " bytes/board" << endl;
+  }
+  close(fd);
+  return 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
   srand(static_cast<unsigned int>(time(0)));
 
-  vector<string> word_list = read_word_list("wordlist.txt");
+  string mode = argc > 1 ? argv[1] : "";
+  if (mode == "startup") {
+    return bench_startup();
+  }
+  if (mode == "multi") {
+    return run_multi(argc > 2 ? atoi(argv[2]) : 4, argc > 3 ? atoi(argv[3]) : WORD_LENGTH,
+                     argc > 4 ? argv[4] : "wordlist.txt");
+  }
+  if (mode == "boards") {
+    return bench_boards();
+  }
+
+  WordList word_list;
+  load_words(word_list);
+
+  if (mode == "table") {
+    return build_table(word_list, argc > 2 ? argv[2] : "patterns.bin");
+  }
+  if (mode == "snapshot") {
+    WordList text;
+    if (!text.load_text("wordlist.txt") || !text.save_snapshot("wordlist.bin")) {
+      cerr << "Error: Could not write wordlist.bin" << endl;
+      return 1;
+    }
+    cout << text.size() << " words written to wordlist.bin" << endl;
+    return 0;
+  }
+  if (mode == "serve" || mode == "loadgen") {
+    WordIndex index;
+    index.build(vector<PackedWord>(word_list.begin(), word_list.end()));
+    if (mode == "serve") {
+      GameServer server(word_list, index, SERVER_CAPACITY, (unsigned)time(0));
+      return argc > 2 ? server.serve_socket(argv[2]) : server.serve_stream(stdin, stdout);
+    }
+    size_t games = argc > 2 ? strtoul(argv[2], NULL, 10) : 200000;
+    size_t concurrent = argc > 3 ? strtoul(argv[3], NULL, 10) : 100000;
+    function<void(const string&, string&)> request;
+    unique_ptr<GameServer> local;
+    if (argc > 4) {
+      if (!connect_socket(argv[4], request)) {
+        cerr << "Error: Could not connect to " << argv[4] << endl;
+        return 1;
+      }
+    } else {
+      local.reset(new GameServer(word_list, index, max(concurrent, (size_t)1), (unsigned)time(0)));
+      request = [&](const string& line, string& reply) {
+        reply.clear();
+        local->handle(line.data(), line.size(), reply);
+        reply.pop_back(); // newline
+      };
+    }
+    return run_load_generator(request, word_list, games, max(concurrent, (size_t)1), 114);
+  }
+  if (mode == "simulate") {
+    return run_simulation(word_list, argc > 2 ? argv[2] : "entropy", argc > 3 ? strtoul(argv[3], NULL, 10) : 0,
+                          argc > 4 ? strtoull(argv[4], NULL, 10) : 114);
+  }
+  if (mode == "filter") {
+    return bench_filter(word_list);
+  }
+  if (mode == "render") {
+    return bench_render(word_list, argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000);
+  }
+  if (mode == "lookups") {
+    return bench_lookups(word_list);
+  }
+  if (mode == "solve") {
+    return run_solver(word_list, argc > 2 ? argv[2] : "");
+  }
 
-  sort(word_list.begin(), word_list.end());
+  WordIndex index;
+  index.build(vector<PackedWord>(word_list.begin(), word_list.end()));
 
   cout << "Welcome to Wordle!" << endl;
 
-  play_game(word_list);
+  while (play_game(word_list, index)) {
+  }
 
   return 0;
 }
\ No newline at end of file
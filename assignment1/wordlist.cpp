@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "wordlist.h"
+
+using namespace std;
+
+static const char SNAPSHOT_MAGIC[4] = {'W', 'D', 'S', '1'};
+static const size_t SNAPSHOT_HEADER = 8;
+
+// first letter in the high bits, so numeric order is alphabetical order
+static uint32_t alpha_key(PackedWord w) {
+  uint32_t key = 0;
+  for (int i = 0; i < WORD_LENGTH; ++i) {
+    key = (key << 5) | word_letter(w, i);
+  }
+  return key;
+}
+
+static bool alpha_less(PackedWord a, PackedWord b) {
+  return alpha_key(a) < alpha_key(b);
+}
+
+// maps path read-only; size 0 files come back as (NULL, 0)
+static bool map_file(const string& path, void*& data, size_t& size) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  data = NULL;
+  size = st.st_size;
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+  }
+  close(fd);
+  return true;
+}
+
+void WordList::clear() {
+  if (m_map) {
+    munmap(m_map, m_map_size);
+  }
+  m_map = NULL;
+  m_map_size = 0;
+  m_owned.clear();
+  m_words = NULL;
+  m_size = 0;
+}
+
+bool WordList::load_text(const string& path) {
+  clear();
+  void* data;
+  size_t size;
+  if (!map_file(path, data, size)) {
+    return false;
+  }
+  const char* p = static_cast<const char*>(data);
+  const char* end = p + size;
+  m_owned.reserve(size / (WORD_LENGTH + 1));
+  while (p < end) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!eol) {
+      eol = end;
+    }
+    size_t len = eol - p;
+    if (len > 0 && p[len - 1] == '\r') {
+      --len;
+    }
+    PackedWord w = 0;
+    bool ok = len == WORD_LENGTH;
+    for (int i = 0; ok && i < WORD_LENGTH; ++i) {
+      char c = p[i] | 0x20;
+      ok = c >= 'a' && c <= 'z';
+      w |= (PackedWord)(c - 'a') << (5 * i);
+    }
+    if (ok) {
+      m_owned.push_back(w);
+    }
+    p = eol + 1;
+  }
+  if (data) {
+    munmap(data, size);
+  }
+
+  // the list ships sorted, so this is usually just the check
+  if (!is_sorted(m_owned.begin(), m_owned.end(), alpha_less)) {
+    sort(m_owned.begin(), m_owned.end(), alpha_less);
+  }
+  m_owned.erase(unique(m_owned.begin(), m_owned.end()), m_owned.end());
+  m_words = m_owned.data();
+  m_size = m_owned.size();
+  return true;
+}
+
+bool WordList::load_snapshot(const string& path) {
+  clear();
+  void* data;
+  size_t size;
+  if (!map_file(path, data, size)) {
+    return false;
+  }
+  m_map = data;
+  m_map_size = size;
+  const char* base = static_cast<const char*>(data);
+  uint32_t count = 0;
+  if (size >= SNAPSHOT_HEADER) {
+    memcpy(&count, base + 4, 4);
+  }
+  if (size < SNAPSHOT_HEADER || memcmp(base, SNAPSHOT_MAGIC, 4) != 0 ||
+      size != SNAPSHOT_HEADER + (size_t)count * sizeof(PackedWord)) {
+    clear();
+    return false;
+  }
+  m_words = reinterpret_cast<const PackedWord*>(base + SNAPSHOT_HEADER);
+  m_size = count;
+  return true;
+}
+
+bool WordList::save_snapshot(const string& path) const {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+  uint32_t count = (uint32_t)m_size;
+  bool ok = fwrite(SNAPSHOT_MAGIC, 1, 4, f) == 4 && fwrite(&count, 4, 1, f) == 1 &&
+            fwrite(m_words, sizeof(PackedWord), m_size, f) == m_size;
+  return fclose(f) == 0 && ok;
+}
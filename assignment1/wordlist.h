@@ -0,0 +1,43 @@
+#ifndef __WORDLIST_H__
+#define __WORDLIST_H__
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "feedback.h"
+
+// Sorted list of packed words. Either parsed from a text file (one word
+// per line, mapped and read in place, no string per word) or mapped from a
+// snapshot written by save_snapshot(), which needs no parsing or sorting at
+// all:
+//
+//   "WDS1", word count as uint32, then the packed words as uint32
+//
+// Text lines that aren't 5 letters are skipped and duplicates dropped.
+class WordList {
+public:
+  WordList() : m_words(NULL), m_size(0), m_map(NULL), m_map_size(0) {}
+  ~WordList() { clear(); }
+
+  bool load_text(const std::string& path);
+  bool load_snapshot(const std::string& path);
+  bool save_snapshot(const std::string& path) const;
+
+  size_t size() const { return m_size; }
+  PackedWord operator[](size_t i) const { return m_words[i]; }
+  const PackedWord* begin() const { return m_words; }
+  const PackedWord* end() const { return m_words + m_size; }
+  std::string word(size_t i) const { return unpack_word(m_words[i]); }
+
+private:
+  WordList(const WordList&);
+  WordList& operator=(const WordList&);
+  void clear();
+
+  const PackedWord* m_words;
+  size_t m_size;
+  std::vector<PackedWord> m_owned; // after load_text()
+  void* m_map; // after load_snapshot()
+  size_t m_map_size;
+};
+
+#endif
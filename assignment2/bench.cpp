@@ -0,0 +1,490 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sys/resource.h>
+#include "system.h"
+#include "kernels.h"
+
+using namespace std;
+
+// Benchmarks for System::solve().
+//
+//   g++ -std=c++17 -O3 bench.cpp system.cpp sparse.cpp iterative.cpp threadpool.cpp kernels.cpp -pthread -o bench
+//   ./bench threads [n] [max threads]
+//   ./bench kernels [r] [w]
+//   ./bench families [max n] [threads]
+//   ./bench iterative [k] [threads]
+//
+// threads: solves the same random dense n x n system with 1, 2, 4, ...
+// threads and reports the time, GFLOP/s and the speedup over the serial
+// path. The solution must come out bit for bit the same for every thread
+// count.
+//
+// kernels: GFLOP/s of the axpy and rank-r update kernels for every
+// instruction set this CPU supports, plus a whole solve with each of them.
+//
+// families: solves reproducible systems from six families at n = 16, 32,
+// ... up to max n (8192 by default) and reports time, GFLOP/s, peak RSS,
+// the relative residual ||b - Ax|| / ||b|| and whether the 0/1/infinite
+// classification came out as built. Exits with 1 on any misclassification.
+//
+//   random        dense uniform entries, one solution
+//   dominant      diagonally dominant, one solution
+//   rankdef       the second half of the rows are sums of two earlier rows,
+//                 b consistent, infinitely many solutions
+//   inconsistent  rankdef with one dependent b entry bumped, no solution
+//   tall          n x n/2, extra rows dependent and consistent, one solution
+//   wide          n/2 x n, infinitely many solutions
+//
+// iterative: the 5-point Laplacian on a k x k grid (256 by default, so
+// n = 65536), sparse and SPD, solved directly and with every Krylov method
+// and preconditioner that applies. Reports time, iterations, the relative
+// residual and the speedup over the direct solve.
+
+vector<vector<double> > random_system(int n, unsigned seed)
+{
+  mt19937_64 gen(seed);
+  uniform_real_distribution<double> dist(-1.0, 1.0);
+  vector<vector<double> > matrix(n, vector<double>(n + 1));
+  for (int i = 0; i < n; ++i)
+  {
+    for (int j = 0; j <= n; ++j)
+    {
+      matrix[i][j] = dist(gen);
+    }
+  }
+  return matrix;
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int bench_threads(int n, int max_threads)
+{
+  vector<vector<double> > matrix = random_system(n, 114);
+  double flops = 2.0 / 3.0 * n * (double)n * n;
+
+  cout << "n = " << n << endl;
+  cout << setw(8) << "threads" << setw(12) << "seconds" << setw(10) << "GFLOP/s" << setw(10) << "speedup" << setw(12) << "identical" << endl;
+
+  vector<double> serial;
+  double serial_time = 0;
+  for (int t = 1; t <= max_threads; t = (t * 2 > max_threads && t != max_threads) ? max_threads : t * 2)
+  {
+    System sys(n, n, matrix);
+    sys.setNumThreads(t);
+    auto start = chrono::steady_clock::now();
+    sys.solve();
+    double secs = seconds_since(start);
+
+    vector<double> sol = sys.getSolution();
+    if (t == 1)
+    {
+      serial = sol;
+      serial_time = secs;
+    }
+    cout << setw(8) << t << setw(12) << fixed << setprecision(4) << secs
+         << setw(10) << setprecision(2) << flops / secs / 1e9
+         << setw(10) << serial_time / secs
+         << setw(12) << (sol == serial ? "yes" : "NO") << endl;
+  }
+  return 0;
+}
+
+int bench_kernels(size_t r, size_t w)
+{
+  const size_t rows = 256; // trailing rows updated per pass
+  const size_t stride = (w + 7) / 8 * 8;
+  mt19937_64 gen(114);
+  uniform_real_distribution<double> dist(-1.0, 1.0);
+  vector<double> l(rows * r), u(r * stride), a(rows * stride), ref;
+  for (size_t i = 0; i < l.size(); ++i)
+  {
+    l[i] = dist(gen);
+  }
+  for (size_t i = 0; i < u.size(); ++i)
+  {
+    u[i] = dist(gen);
+  }
+
+  cout << "rank-" << r << " update of " << rows << " x " << w << " rows" << endl;
+  cout << setw(8) << "isa" << setw(14) << "axpy GFLOP/s" << setw(16) << "update GFLOP/s" << setw(14) << "max |diff|" << endl;
+
+  KernelIsa all[] = {KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512};
+  for (size_t t = 0; t < 3; ++t)
+  {
+    if (!kernelSupported(all[t]))
+    {
+      continue;
+    }
+    const Kernels &k = kernelsFor(all[t]);
+
+    // axpy over the u block, rows * r calls of length w
+    fill(a.begin(), a.end(), 0.0);
+    int reps = 0;
+    auto start = chrono::steady_clock::now();
+    do
+    {
+      for (size_t i = 0; i < rows; ++i)
+      {
+        for (size_t p = 0; p < r; ++p)
+        {
+          k.axpy(&a[i * stride], &u[p * stride], l[i * r + p], w);
+        }
+      }
+      ++reps;
+    } while (seconds_since(start) < 0.5);
+    double axpy_gflops = 2.0 * rows * r * w * reps / seconds_since(start) / 1e9;
+
+    fill(a.begin(), a.end(), 0.0);
+    reps = 0;
+    start = chrono::steady_clock::now();
+    do
+    {
+      for (size_t i = 0; i < rows; i += 4)
+      {
+        double *ap[4] = {&a[i * stride], &a[(i + 1) * stride], &a[(i + 2) * stride], &a[(i + 3) * stride]};
+        k.rankUpdate(ap, 4, &l[i * r], r, &u[0], stride, w);
+      }
+      ++reps;
+    } while (seconds_since(start) < 0.5);
+    double update_gflops = 2.0 * rows * r * w * reps / seconds_since(start) / 1e9;
+
+    // one more pass from zero to compare against the scalar results
+    fill(a.begin(), a.end(), 0.0);
+    for (size_t i = 0; i < rows; i += 4)
+    {
+      double *ap[4] = {&a[i * stride], &a[(i + 1) * stride], &a[(i + 2) * stride], &a[(i + 3) * stride]};
+      k.rankUpdate(ap, 4, &l[i * r], r, &u[0], stride, w);
+    }
+    if (ref.empty())
+    {
+      ref = a;
+    }
+    double diff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      diff = max(diff, fabs(a[i] - ref[i]));
+    }
+
+    cout << setw(8) << k.name << setw(14) << fixed << setprecision(2) << axpy_gflops
+         << setw(16) << update_gflops << setw(14) << scientific << setprecision(1) << diff << endl;
+  }
+
+  int n = 1024;
+  double flops = 2.0 / 3.0 * n * (double)n * n;
+  vector<vector<double> > matrix = random_system(n, 114);
+  cout << endl << "solve, n = " << n << ", 1 thread" << endl;
+  for (size_t t = 0; t < 3; ++t)
+  {
+    if (!kernelSupported(all[t]))
+    {
+      continue;
+    }
+    setActiveKernels(all[t]);
+    System sys(n, n, matrix);
+    sys.setNumThreads(1);
+    auto start = chrono::steady_clock::now();
+    sys.solve();
+    double secs = seconds_since(start);
+    cout << setw(8) << kernelsFor(all[t]).name << setw(12) << fixed << setprecision(4) << secs
+         << setw(10) << setprecision(2) << flops / secs / 1e9 << " GFLOP/s" << endl;
+  }
+  return 0;
+}
+
+// one generated system: rows holds n rows of m coefficients and b
+struct Family
+{
+  string name;
+  size_t n, m;
+  int expect;
+  vector<double> rows;
+};
+
+Family make_family(const string &name, size_t size, unsigned seed)
+{
+  mt19937_64 gen(seed);
+  uniform_real_distribution<double> dist(-1.0, 1.0);
+  Family f;
+  f.name = name;
+  f.n = name == "wide" ? size / 2 : size;
+  f.m = name == "tall" ? size / 2 : size;
+  f.expect = (name == "rankdef" || name == "wide") ? 2 : name == "inconsistent" ? 0 : 1;
+  size_t n = f.n, m = f.m, w = m + 1;
+  f.rows.resize(n * w);
+
+  // independent rows, the rest are sums of two of them
+  size_t indep = (name == "rankdef" || name == "inconsistent") ? n / 2 : min(n, m);
+  for (size_t i = 0; i < indep; ++i)
+  {
+    for (size_t j = 0; j < m; ++j)
+    {
+      f.rows[i * w + j] = dist(gen);
+    }
+    if (name == "dominant")
+    {
+      f.rows[i * w + i] += m;
+    }
+  }
+  for (size_t i = indep; i < n; ++i)
+  {
+    size_t a = gen() % indep, b = gen() % indep;
+    for (size_t j = 0; j < m; ++j)
+    {
+      f.rows[i * w + j] = f.rows[a * w + j] + f.rows[b * w + j];
+    }
+  }
+
+  // b = A x for a random x keeps every family consistent
+  vector<double> x(m);
+  for (size_t j = 0; j < m; ++j)
+  {
+    x[j] = dist(gen);
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    double s = 0;
+    for (size_t j = 0; j < m; ++j)
+    {
+      s += f.rows[i * w + j] * x[j];
+    }
+    f.rows[i * w + m] = s;
+  }
+  if (name == "inconsistent")
+  {
+    f.rows[(n - 1) * w + m] += 1.0;
+  }
+  return f;
+}
+
+// resets the kernel's peak RSS counter (Linux 4.0+), false if it can't
+bool reset_peak_rss()
+{
+  ofstream clear("/proc/self/clear_refs");
+  clear << "5";
+  return (bool)clear;
+}
+
+// peak resident set size in MB, since the last reset where supported
+double peak_rss_mb()
+{
+  ifstream status("/proc/self/status");
+  string key;
+  while (status >> key)
+  {
+    if (key == "VmHWM:")
+    {
+      double kb;
+      status >> kb;
+      return kb / 1024;
+    }
+    status.ignore(1 << 10, '\n');
+  }
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss / 1024.0;
+}
+
+int bench_families(size_t max_n, int threads)
+{
+  const char *names[] = {"random", "dominant", "rankdef", "inconsistent", "tall", "wide"};
+  const char *kinds[] = {"none", "one", "inf"};
+  int failures = 0;
+
+  cout << setw(13) << "family" << setw(7) << "n" << setw(7) << "m" << setw(11) << "seconds"
+       << setw(9) << "GFLOP/s" << setw(10) << "peak MB" << setw(11) << "residual"
+       << setw(7) << "expect" << setw(6) << "got" << endl;
+  for (size_t f = 0; f < 6; ++f)
+  {
+    for (size_t size = 16; size <= max_n; size *= 2)
+    {
+      Family fam = make_family(names[f], size, 114 + size);
+      size_t n = fam.n, m = fam.m, w = m + 1;
+      double r = min(n, m);
+      double flops = 2.0 * (n * (double)m * r - (n + m) * r * r / 2 + r * r * r / 3);
+
+      reset_peak_rss();
+      System sys(n, m, fam.rows.data(), w);
+      sys.setNumThreads(threads);
+      auto start = chrono::steady_clock::now();
+      sys.solve();
+      double secs = seconds_since(start);
+      double peak = peak_rss_mb();
+
+      vector<double> sol = sys.getSolution();
+      double rnorm = 0, bnorm = 0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        double s = fam.rows[i * w + m];
+        bnorm += s * s;
+        for (size_t j = 0; j < m; ++j)
+        {
+          s -= fam.rows[i * w + j] * sol[j];
+        }
+        rnorm += s * s;
+      }
+      int got = sys.getNumSolutions();
+      bool ok = got == fam.expect;
+      failures += !ok;
+
+      cout << setw(13) << fam.name << setw(7) << n << setw(7) << m
+           << setw(11) << fixed << setprecision(5) << secs
+           << setw(9) << setprecision(2) << flops / secs / 1e9
+           << setw(10) << setprecision(1) << peak
+           << setw(11) << scientific << setprecision(1) << sqrt(rnorm / bnorm)
+           << setw(7) << kinds[fam.expect] << setw(6) << (got >= 0 && got <= 2 ? kinds[got] : "?")
+           << (ok ? "" : "  MISMATCH") << endl;
+    }
+  }
+  return failures ? 1 : 0;
+}
+
+int bench_iterative(size_t k, int threads)
+{
+  size_t n = k * k;
+  vector<Triplet> t;
+  for (size_t i = 0; i < k; ++i)
+  {
+    for (size_t j = 0; j < k; ++j)
+    {
+      size_t p = i * k + j;
+      t.push_back(Triplet(p, p, 4.0));
+      if (i > 0)
+      {
+        t.push_back(Triplet(p, p - k, -1.0));
+      }
+      if (i + 1 < k)
+      {
+        t.push_back(Triplet(p, p + k, -1.0));
+      }
+      if (j > 0)
+      {
+        t.push_back(Triplet(p, p - 1, -1.0));
+      }
+      if (j + 1 < k)
+      {
+        t.push_back(Triplet(p, p + 1, -1.0));
+      }
+    }
+  }
+  SparseMatrix a = SparseMatrix::fromTriplets(n, n, t);
+  mt19937_64 gen(114);
+  uniform_real_distribution<double> dist(-1.0, 1.0);
+  vector<double> b(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    b[i] = dist(gen);
+  }
+
+  struct Run
+  {
+    const char *name;
+    SolveMethod method;
+    Preconditioner precond;
+  };
+  Run runs[] = {{"direct", SOLVE_DIRECT, PRECOND_NONE},         {"cg", SOLVE_CG, PRECOND_NONE},
+                {"cg jacobi", SOLVE_CG, PRECOND_JACOBI},        {"cg ilu0", SOLVE_CG, PRECOND_ILU0},
+                {"gmres ilu0", SOLVE_GMRES, PRECOND_ILU0},      {"bicgstab ilu0", SOLVE_BICGSTAB, PRECOND_ILU0}};
+
+  cout << "5-point Laplacian, " << k << " x " << k << " grid, n = " << n << ", " << a.nonzeros() << " nonzeros" << endl;
+  cout << setw(15) << "method" << setw(11) << "seconds" << setw(8) << "iters" << setw(11) << "residual"
+       << setw(6) << "sols" << setw(10) << "speedup" << endl;
+  double direct = 0;
+  int failures = 0;
+  for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); ++r)
+  {
+    IterativeOptions opt;
+    opt.method = runs[r].method;
+    opt.precond = runs[r].precond;
+    opt.maxIter = 10 * k;
+    System sys(a, b);
+    sys.setNumThreads(threads);
+    sys.setIterative(opt);
+    auto start = chrono::steady_clock::now();
+    sys.solve();
+    double secs = seconds_since(start);
+    if (r == 0)
+    {
+      direct = secs;
+    }
+
+    vector<double> x = sys.getSolution();
+    double rnorm = 0, bnorm = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      double s = b[i];
+      for (size_t q = a.rowptr[i]; q < a.rowptr[i + 1]; ++q)
+      {
+        s -= a.values[q] * x[a.colind[q]];
+      }
+      rnorm += s * s;
+      bnorm += b[i] * b[i];
+    }
+    IterativeStats st = sys.getIterativeStats();
+    failures += sys.getNumSolutions() != 1;
+    cout << setw(15) << runs[r].name << setw(11) << fixed << setprecision(4) << secs << setw(8) << st.iterations
+         << setw(11) << scientific << setprecision(1) << sqrt(rnorm / bnorm) << setw(6) << sys.getNumSolutions()
+         << setw(10) << fixed << setprecision(2) << direct / secs << (st.fellBack ? "  fell back" : "") << endl;
+  }
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  string mode = argc > 1 ? argv[1] : "threads";
+  if (mode == "threads")
+  {
+    int n = argc > 2 ? atoi(argv[2]) : 2048;
+    int max_threads = argc > 3 ? atoi(argv[3]) : (int)thread::hardware_concurrency();
+    if (n > 0 && max_threads > 0)
+    {
+      return bench_threads(n, max_threads);
+    }
+  }
+  else if (mode == "kernels")
+  {
+    int r = argc > 2 ? atoi(argv[2]) : 64;
+    int w = argc > 3 ? atoi(argv[3]) : 256;
+    if (r > 0 && w > 0)
+    {
+      return bench_kernels(r, w);
+    }
+  }
+
+  else if (mode == "families")
+  {
+    int max_n = argc > 2 ? atoi(argv[2]) : 8192;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+    if (max_n >= 16 && threads >= 0)
+    {
+      return bench_families(max_n, threads);
+    }
+  }
+
+  else if (mode == "iterative")
+  {
+    int k = argc > 2 ? atoi(argv[2]) : 256;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+    if (k >= 2 && threads >= 0)
+    {
+      return bench_iterative(k, threads);
+    }
+  }
+
+  cerr << "usage: " << argv[0] << " threads [n] [max threads]" << endl;
+  cerr << "       " << argv[0] << " kernels [r] [w]" << endl;
+  cerr << "       " << argv[0] << " families [max n] [threads]" << endl;
+  cerr << "       " << argv[0] << " iterative [k] [threads]" << endl;
+  return 1;
+}
@@ -0,0 +1,269 @@
+#include <cstdint>
+#include "elements.h"
+
+// The periodic table itself, by atomic number; entry 0 is unused. This is
+// the only copy of the data (it started out as elements.csv, read at
+// startup), so edit it here.
+static constexpr Element ELEMENTS[NUM_ELEMENTS + 1] = {
+	{"", "", 0, 0.0, "", ""},
+	{"H", "Hydrogen", 1, 1.007, "gas", "Nonmetal"},
+	{"He", "Helium", 2, 4.002, "gas", "Noble Gas"},
+	{"Li", "Lithium", 3, 6.941, "solid", "Alkali Metal"},
+	{"Be", "Beryllium", 4, 9.012, "solid", "Alkaline Earth Metal"},
+	{"B", "Boron", 5, 10.811, "solid", "Metalloid"},
+	{"C", "Carbon", 6, 12.011, "solid", "Nonmetal"},
+	{"N", "Nitrogen", 7, 14.007, "gas", "Nonmetal"},
+	{"O", "Oxygen", 8, 15.999, "gas", "Nonmetal"},
+	{"F", "Fluorine", 9, 18.998, "gas", "Halogen"},
+	{"Ne", "Neon", 10, 20.18, "gas", "Noble Gas"},
+	{"Na", "Sodium", 11, 22.99, "solid", "Alkali Metal"},
+	{"Mg", "Magnesium", 12, 24.305, "solid", "Alkaline Earth Metal"},
+	{"Al", "Aluminum", 13, 26.982, "solid", "Metal"},
+	{"Si", "Silicon", 14, 28.086, "solid", "Metalloid"},
+	{"P", "Phosphorus", 15, 30.974, "solid", "Nonmetal"},
+	{"S", "Sulfur", 16, 32.065, "solid", "Nonmetal"},
+	{"Cl", "Chlorine", 17, 35.453, "gas", "Halogen"},
+	{"Ar", "Argon", 18, 39.948, "gas", "Noble Gas"},
+	{"K", "Potassium", 19, 39.098, "solid", "Alkali Metal"},
+	{"Ca", "Calcium", 20, 40.078, "solid", "Alkaline Earth Metal"},
+	{"Sc", "Scandium", 21, 44.956, "solid", "Transition Metal"},
+	{"Ti", "Titanium", 22, 47.867, "solid", "Transition Metal"},
+	{"V", "Vanadium", 23, 50.942, "solid", "Transition Metal"},
+	{"Cr", "Chromium", 24, 51.996, "solid", "Transition Metal"},
+	{"Mn", "Manganese", 25, 54.938, "solid", "Transition Metal"},
+	{"Fe", "Iron", 26, 55.845, "solid", "Transition Metal"},
+	{"Co", "Cobalt", 27, 58.933, "solid", "Transition Metal"},
+	{"Ni", "Nickel", 28, 58.693, "solid", "Transition Metal"},
+	{"Cu", "Copper", 29, 63.546, "solid", "Transition Metal"},
+	{"Zn", "Zinc", 30, 65.38, "solid", "Transition Metal"},
+	{"Ga", "Gallium", 31, 69.723, "solid", "Metal"},
+	{"Ge", "Germanium", 32, 72.64, "solid", "Metalloid"},
+	{"As", "Arsenic", 33, 74.922, "solid", "Metalloid"},
+	{"Se", "Selenium", 34, 78.96, "solid", "Nonmetal"},
+	{"Br", "Bromine", 35, 79.904, "liquid", "Halogen"},
+	{"Kr", "Krypton", 36, 83.798, "gas", "Noble Gas"},
+	{"Rb", "Rubidium", 37, 85.468, "solid", "Alkali Metal"},
+	{"Sr", "Strontium", 38, 87.62, "solid", "Alkaline Earth Metal"},
+	{"Y", "Yttrium", 39, 88.906, "solid", "Transition Metal"},
+	{"Zr", "Zirconium", 40, 91.224, "solid", "Transition Metal"},
+	{"Nb", "Niobium", 41, 92.906, "solid", "Transition Metal"},
+	{"Mo", "Molybdenum", 42, 95.96, "solid", "Transition Metal"},
+	{"Tc", "Technetium", 43, 98, "artificial", "Transition Metal"},
+	{"Ru", "Ruthenium", 44, 101.07, "solid", "Transition Metal"},
+	{"Rh", "Rhodium", 45, 102.906, "solid", "Transition Metal"},
+	{"Pd", "Palladium", 46, 106.42, "solid", "Transition Metal"},
+	{"Ag", "Silver", 47, 107.868, "solid", "Transition Metal"},
+	{"Cd", "Cadmium", 48, 112.411, "solid", "Transition Metal"},
+	{"In", "Indium", 49, 114.818, "solid", "Metal"},
+	{"Sn", "Tin", 50, 118.71, "solid", "Metal"},
+	{"Sb", "Antimony", 51, 121.76, "solid", "Metalloid"},
+	{"Te", "Tellurium", 52, 127.6, "solid", "Metalloid"},
+	{"I", "Iodine", 53, 126.904, "solid", "Halogen"},
+	{"Xe", "Xenon", 54, 131.293, "gas", "Noble Gas"},
+	{"Cs", "Cesium", 55, 132.905, "solid", "Alkali Metal"},
+	{"Ba", "Barium", 56, 137.327, "solid", "Alkaline Earth Metal"},
+	{"La", "Lanthanum", 57, 138.905, "solid", "Lanthanide"},
+	{"Ce", "Cerium", 58, 140.116, "solid", "Lanthanide"},
+	{"Pr", "Praseodymium", 59, 140.908, "solid", "Lanthanide"},
+	{"Nd", "Neodymium", 60, 144.242, "solid", "Lanthanide"},
+	{"Pm", "Promethium", 61, 145, "artificial", "Lanthanide"},
+	{"Sm", "Samarium", 62, 150.36, "solid", "Lanthanide"},
+	{"Eu", "Europium", 63, 151.964, "solid", "Lanthanide"},
+	{"Gd", "Gadolinium", 64, 157.25, "solid", "Lanthanide"},
+	{"Tb", "Terbium", 65, 158.925, "solid", "Lanthanide"},
+	{"Dy", "Dysprosium", 66, 162.5, "solid", "Lanthanide"},
+	{"Ho", "Holmium", 67, 164.93, "solid", "Lanthanide"},
+	{"Er", "Erbium", 68, 167.259, "solid", "Lanthanide"},
+	{"Tm", "Thulium", 69, 168.934, "solid", "Lanthanide"},
+	{"Yb", "Ytterbium", 70, 173.054, "solid", "Lanthanide"},
+	{"Lu", "Lutetium", 71, 174.967, "solid", "Lanthanide"},
+	{"Hf", "Hafnium", 72, 178.49, "solid", "Transition Metal"},
+	{"Ta", "Tantalum", 73, 180.948, "solid", "Transition Metal"},
+	{"W", "Tungsten", 74, 183.84, "solid", "Transition Metal"},
+	{"Re", "Rhenium", 75, 186.207, "solid", "Transition Metal"},
+	{"Os", "Osmium", 76, 190.23, "solid", "Transition Metal"},
+	{"Ir", "Iridium", 77, 192.217, "solid", "Transition Metal"},
+	{"Pt", "Platinum", 78, 195.084, "solid", "Transition Metal"},
+	{"Au", "Gold", 79, 196.967, "solid", "Transition Metal"},
+	{"Hg", "Mercury", 80, 200.59, "liquid", "Transition Metal"},
+	{"Tl", "Thallium", 81, 204.383, "solid", "Metal"},
+	{"Pb", "Lead", 82, 207.2, "solid", "Metal"},
+	{"Bi", "Bismuth", 83, 208.98, "solid", "Metal"},
+	{"Po", "Polonium", 84, 210, "solid", "Metalloid"},
+	{"At", "Astatine", 85, 210, "solid", "Halogen"},
+	{"Rn", "Radon", 86, 222, "gas", "Noble Gas"},
+	{"Fr", "Francium", 87, 223, "solid", "Alkaline Metal"},
+	{"Ra", "Radium", 88, 226, "solid", "Alkaline Earth Metal"},
+	{"Ac", "Actinium", 89, 227, "solid", "Actinide"},
+	{"Th", "Thorium", 90, 232.038, "solid", "Actinide"},
+	{"Pa", "Protactinium", 91, 231.036, "solid", "Actinide"},
+	{"U", "Uranium", 92, 238.029, "solid", "Actinide"},
+	{"Np", "Neptunium", 93, 237, "artificial", "Actinide"},
+	{"Pu", "Plutonium", 94, 244, "artificial", "Actinide"},
+	{"Am", "Americium", 95, 243, "artificial", "Actinide"},
+	{"Cm", "Curium", 96, 247, "artificial", "Actinide"},
+	{"Bk", "Berkelium", 97, 247, "artificial", "Actinide"},
+	{"Cf", "Californium", 98, 251, "artificial", "Actinide"},
+	{"Es", "Einsteinium", 99, 252, "artificial", "Actinide"},
+	{"Fm", "Fermium", 100, 257, "artificial", "Actinide"},
+	{"Md", "Mendelevium", 101, 258, "artificial", "Actinide"},
+	{"No", "Nobelium", 102, 259, "artificial", "Actinide"},
+	{"Lr", "Lawrencium", 103, 262, "artificial", "Actinide"},
+	{"Rf", "Rutherfordium", 104, 261, "artificial", "Transactinide"},
+	{"Db", "Dubnium", 105, 262, "artificial", "Transactinide"},
+	{"Sg", "Seaborgium", 106, 266, "artificial", "Transactinide"},
+	{"Bh", "Bohrium", 107, 264, "artificial", "Transactinide"},
+	{"Hs", "Hassium", 108, 267, "artificial", "Transactinide"},
+	{"Mt", "Meitnerium", 109, 268, "artificial", "Transactinide"},
+	{"Ds", "Darmstadtium", 110, 271, "artificial", "Transactinide"},
+	{"Rg", "Roentgenium", 111, 272, "artificial", "Transactinide"},
+	{"Cn", "Copernicium", 112, 285, "artificial", "Transactinide"},
+	{"Nh", "Nihonium", 113, 284, "artificial", ""},
+	{"Fl", "Flerovium", 114, 289, "artificial", "Transactinide"},
+	{"Mc", "Moscovium", 115, 288, "artificial", ""},
+	{"Lv", "Livermorium", 116, 292, "artificial", "Transactinide"},
+	{"Ts", "Tennessine", 117, 295, "artificial", ""},
+	{"Og", "Oganesson", 118, 294, "artificial", "Noble Gas"},
+};
+
+// FNV-1a over the letters folded to lowercase (c | 0x20, exact for
+// letters), then the murmur3 finalizer so every seed gives an unrelated
+// function
+static constexpr uint32_t fold_hash(const char *s, size_t len, uint32_t seed)
+{
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (size_t i = 0; i < len; ++i)
+	{
+		h = (h ^ (uint8_t)(s[i] | 0x20)) * 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+static constexpr std::string_view key_of(int number, bool by_symbol)
+{
+	return by_symbol ? ELEMENTS[number].symbol : ELEMENTS[number].name;
+}
+
+// Minimal perfect hash over the symbols or the names ("hash and
+// displace"): a first hash spreads the keys over BUCKETS buckets, then
+// each bucket, biggest first, gets the first seed that sends all of its
+// keys to slots nobody has taken. The 118 keys end up in 118 slots, so a
+// lookup is two hashes and one compare.
+struct ElementHash
+{
+	static constexpr int BUCKETS = NUM_ELEMENTS / 2;
+	static constexpr uint32_t MAX_SEED = 100000;
+
+	uint32_t seed[BUCKETS];
+	uint8_t number[NUM_ELEMENTS]; // element in each slot
+
+	constexpr ElementHash(bool by_symbol) : seed(), number()
+	{
+		int bucket[NUM_ELEMENTS + 1] = {};
+		int bucket_size[BUCKETS] = {};
+		for (int e = 1; e <= NUM_ELEMENTS; ++e)
+		{
+			std::string_view key = key_of(e, by_symbol);
+			bucket[e] = fold_hash(key.data(), key.size(), 0) % BUCKETS;
+			++bucket_size[bucket[e]];
+		}
+
+		// biggest buckets first, while there is the most room
+		int order[BUCKETS] = {};
+		for (int b = 0; b < BUCKETS; ++b)
+		{
+			int i = b;
+			for (; i > 0 && bucket_size[order[i - 1]] < bucket_size[b]; --i)
+			{
+				order[i] = order[i - 1];
+			}
+			order[i] = b;
+		}
+
+		bool used[NUM_ELEMENTS] = {};
+		for (int o = 0; o < BUCKETS && bucket_size[order[o]] > 0; ++o)
+		{
+			int b = order[o];
+			for (uint32_t s = 1; ; ++s)
+			{
+				if (s > MAX_SEED)
+				{
+					throw "no perfect hash seed found";
+				}
+				int slot[NUM_ELEMENTS] = {};
+				int member[NUM_ELEMENTS] = {};
+				int k = 0;
+				bool ok = true;
+				for (int e = 1; e <= NUM_ELEMENTS && ok; ++e)
+				{
+					if (bucket[e] != b)
+					{
+						continue;
+					}
+					std::string_view key = key_of(e, by_symbol);
+					int to = fold_hash(key.data(), key.size(), s) % NUM_ELEMENTS;
+					ok = !used[to];
+					for (int j = 0; j < k && ok; ++j)
+					{
+						ok = slot[j] != to;
+					}
+					slot[k] = to;
+					member[k] = e;
+					++k;
+				}
+				if (ok)
+				{
+					seed[b] = s;
+					for (int j = 0; j < k; ++j)
+					{
+						used[slot[j]] = true;
+						number[slot[j]] = (uint8_t)member[j];
+					}
+					break;
+				}
+			}
+		}
+	}
+};
+
+static constexpr ElementHash SYMBOL_HASH(true);
+static constexpr ElementHash NAME_HASH(false);
+
+static const Element *find(const ElementHash &hash, bool by_symbol, const char *s, size_t len)
+{
+	uint32_t b = fold_hash(s, len, 0) % ElementHash::BUCKETS;
+	const Element &elem = ELEMENTS[hash.number[fold_hash(s, len, hash.seed[b]) % NUM_ELEMENTS]];
+	std::string_view key = by_symbol ? elem.symbol : elem.name;
+	if (key.size() != len)
+	{
+		return NULL;
+	}
+	for (size_t i = 0; i < len; ++i)
+	{
+		if ((s[i] | 0x20) != (key[i] | 0x20))
+		{
+			return NULL;
+		}
+	}
+	return &elem;
+}
+
+const Element *element_by_number(int number)
+{
+	return number >= 1 && number <= NUM_ELEMENTS ? &ELEMENTS[number] : NULL;
+}
+
+const Element *element_by_symbol(const char *s, size_t len)
+{
+	return find(SYMBOL_HASH, true, s, len);
+}
+
+const Element *element_by_name(const char *s, size_t len)
+{
+	return find(NAME_HASH, false, s, len);
+}
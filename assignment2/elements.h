@@ -0,0 +1,27 @@
+#ifndef __ELEMENTS_H__
+#define __ELEMENTS_H__
+#include <cstddef>
+#include <string_view>
+
+struct Element
+{
+	std::string_view symbol; // e.g., "H", "He"
+	std::string_view name;   // e.g., "Hydrogen", "Helium"
+	int number;              // e.g., 1, 2
+	double atomic_mass;      // e.g., 1.008, 4.0026
+	std::string_view phase;  // phase at room temp e.g., gas, liquid, solid
+	std::string_view type;   // e.g., "transitional metals", "noble gas"
+};
+
+const int NUM_ELEMENTS = 118;
+
+// The periodic table is compiled into the program, as one flat table of
+// interned strings in elements.cpp (the only copy of the data), and
+// lookups hand back a pointer into it, NULL when there is no such element.
+// Symbols and names match in any case through minimal perfect hashes built
+// at compile time, so no lookup allocates or copies anything.
+const Element *element_by_number(int number);
+const Element *element_by_symbol(const char *s, size_t len);
+const Element *element_by_name(const char *s, size_t len);
+
+#endif
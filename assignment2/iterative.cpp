@@ -0,0 +1,377 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "iterative.h"
+
+using namespace std;
+
+//rows per chunk of a parallel matrix-vector product
+static const size_t SPMV_GRAIN = 512;
+//the same for a dense matrix, where a row is n multiply-adds
+static const size_t DENSE_GRAIN = 16;
+
+//y = a x, split by rows over pool
+static void spmv(const SparseMatrix& a, const vector<double>& x, vector<double>& y, ThreadPool* pool)
+{
+	y.resize(a.rows);
+	const double* xp = x.data();
+	auto rows = [&](size_t ib, size_t ie) {
+		for (size_t i = ib; i < ie; ++i) {
+			double s = 0;
+			for (size_t t = a.rowptr[i]; t < a.rowptr[i + 1]; ++t)
+				s += a.values[t] * xp[a.colind[t]];
+			y[i] = s;
+		}
+	};
+	if (pool)
+		pool->parallelFor(0, a.rows, SPMV_GRAIN, rows);
+	else
+		rows(0, a.rows);
+}
+
+//y = a x for a dense a, split by rows over pool
+static void spmv(const Matrix& a, const vector<double>& x, vector<double>& y, ThreadPool* pool)
+{
+	y.resize(a.rows());
+	const double* xp = x.data();
+	auto rows = [&](size_t ib, size_t ie) {
+		for (size_t i = ib; i < ie; ++i) {
+			const double* ai = a[i];
+			double s = 0;
+			for (size_t j = 0; j < a.cols(); ++j)
+				s += ai[j] * xp[j];
+			y[i] = s;
+		}
+	};
+	if (pool)
+		pool->parallelFor(0, a.rows(), DENSE_GRAIN, rows);
+	else
+		rows(0, a.rows());
+}
+
+//dot products stay serial so the result does not depend on the thread count
+static double dot(const vector<double>& x, const vector<double>& y)
+{
+	double s = 0;
+	for (size_t i = 0; i < x.size(); ++i)
+		s += x[i] * y[i];
+	return s;
+}
+
+static double norm(const vector<double>& x)
+{
+	return sqrt(dot(x, x));
+}
+
+//r = b - a x
+template <class Mat>
+static void residual(const Mat& a, const vector<double>& b, const vector<double>& x, vector<double>& r, ThreadPool* pool)
+{
+	spmv(a, x, r, pool);
+	for (size_t i = 0; i < r.size(); ++i)
+		r[i] = b[i] - r[i];
+}
+
+//M^-1 for Jacobi (inverse diagonal) or ILU(0) (L and U on the pattern of a)
+class Precond {
+public:
+	Precond(const SparseMatrix& a, Preconditioner kind);
+	//ILU(0) on a dense pattern is a full LU, so it falls back to Jacobi
+	Precond(const Matrix& a, Preconditioner kind);
+	void apply(const vector<double>& r, vector<double>& z) const;
+
+private:
+	Preconditioner m_kind;
+	const SparseMatrix* m_a; //ILU(0) only
+	vector<double> m_invdiag; //Jacobi
+	vector<double> m_lu; //ILU(0): unit L below the diagonal, U on and above it
+	vector<size_t> m_diag; //ILU(0): index of each row's diagonal entry
+};
+
+Precond::Precond(const SparseMatrix& a, Preconditioner kind) : m_kind(kind), m_a(&a)
+{
+	size_t n = a.rows;
+	m_diag.assign(n, 0);
+	for (size_t i = 0; i < n && m_kind != PRECOND_NONE; ++i) {
+		size_t t = lower_bound(a.colind.begin() + a.rowptr[i], a.colind.begin() + a.rowptr[i + 1], i) - a.colind.begin();
+		//a zero diagonal leaves nothing to scale or pivot by
+		if (t == a.rowptr[i + 1] || a.colind[t] != i)
+			m_kind = PRECOND_NONE;
+		m_diag[i] = t;
+	}
+
+	if (m_kind == PRECOND_JACOBI) {
+		m_invdiag.resize(n);
+		for (size_t i = 0; i < n; ++i)
+			m_invdiag[i] = 1.0 / a.values[m_diag[i]];
+	} else if (m_kind == PRECOND_ILU0) {
+		//IKJ elimination restricted to the nonzeros already in each row;
+		//pos maps a column of row i to its slot, or -1 outside the pattern
+		m_lu = a.values;
+		vector<long> pos(a.cols, -1);
+		for (size_t i = 0; i < n && m_kind == PRECOND_ILU0; ++i) {
+			for (size_t t = a.rowptr[i]; t < a.rowptr[i + 1]; ++t)
+				pos[a.colind[t]] = (long) t;
+			for (size_t t = a.rowptr[i]; t < m_diag[i]; ++t) {
+				size_t k = a.colind[t];
+				double l = m_lu[t] / m_lu[m_diag[k]];
+				m_lu[t] = l;
+				for (size_t s = m_diag[k] + 1; s < a.rowptr[k + 1]; ++s)
+					if (pos[a.colind[s]] >= 0)
+						m_lu[pos[a.colind[s]]] -= l * m_lu[s];
+			}
+			for (size_t t = a.rowptr[i]; t < a.rowptr[i + 1]; ++t)
+				pos[a.colind[t]] = -1;
+			if (m_lu[m_diag[i]] == 0.0)
+				m_kind = PRECOND_NONE;
+		}
+	}
+}
+
+Precond::Precond(const Matrix& a, Preconditioner kind) : m_kind(kind == PRECOND_ILU0 ? PRECOND_JACOBI : kind), m_a(NULL)
+{
+	if (m_kind != PRECOND_JACOBI)
+		return;
+	m_invdiag.resize(a.rows());
+	for (size_t i = 0; i < a.rows() && m_kind == PRECOND_JACOBI; ++i) {
+		if (a[i][i] == 0.0)
+			m_kind = PRECOND_NONE;
+		m_invdiag[i] = 1.0 / a[i][i];
+	}
+}
+
+void Precond::apply(const vector<double>& r, vector<double>& z) const
+{
+	size_t n = r.size();
+	z.resize(n);
+	if (m_kind == PRECOND_JACOBI) {
+		for (size_t i = 0; i < n; ++i)
+			z[i] = m_invdiag[i] * r[i];
+	} else if (m_kind == PRECOND_ILU0) {
+		const SparseMatrix& a = *m_a;
+		for (size_t i = 0; i < n; ++i) {
+			double s = r[i];
+			for (size_t t = a.rowptr[i]; t < m_diag[i]; ++t)
+				s -= m_lu[t] * z[a.colind[t]];
+			z[i] = s;
+		}
+		for (size_t i = n; i-- > 0; ) {
+			double s = z[i];
+			for (size_t t = m_diag[i] + 1; t < a.rowptr[i + 1]; ++t)
+				s -= m_lu[t] * z[a.colind[t]];
+			z[i] = s / m_lu[m_diag[i]];
+		}
+	} else {
+		z = r;
+	}
+}
+
+//preconditioned conjugate gradient; stops early if a direction of
+//non-positive curvature shows the matrix is not SPD
+template <class Mat>
+static void cg(const Mat& a, const vector<double>& b, vector<double>& x, const Precond& m,
+	const IterativeOptions& opt, double bnorm, IterativeStats& st, ThreadPool* pool)
+{
+	size_t n = b.size();
+	vector<double> r, z, p, ap;
+	residual(a, b, x, r, pool);
+	m.apply(r, z);
+	p = z;
+	double rz = dot(r, z);
+	while (st.iterations < opt.maxIter && st.residuals.back() > opt.tol) {
+		spmv(a, p, ap, pool);
+		double pap = dot(p, ap);
+		if (pap <= 0.0)
+			return;
+		double alpha = rz / pap;
+		for (size_t i = 0; i < n; ++i) {
+			x[i] += alpha * p[i];
+			r[i] -= alpha * ap[i];
+		}
+		++st.iterations;
+		st.residuals.push_back(norm(r) / bnorm);
+
+		m.apply(r, z);
+		double rznew = dot(r, z);
+		double beta = rznew / rz;
+		rz = rznew;
+		for (size_t i = 0; i < n; ++i)
+			p[i] = z[i] + beta * p[i];
+	}
+}
+
+//GMRES(restart) with right preconditioning, so the residual the Givens
+//rotations track is that of the unpreconditioned system; it is recomputed
+//from b - Ax at every restart
+template <class Mat>
+static void gmres(const Mat& a, const vector<double>& b, vector<double>& x, const Precond& m,
+	const IterativeOptions& opt, double bnorm, IterativeStats& st, ThreadPool* pool)
+{
+	size_t n = b.size();
+	size_t k = max(opt.restart, (size_t) 1);
+	vector< vector<double> > v(k + 1), z(k);
+	vector< vector<double> > h(k + 1, vector<double>(k, 0.0)); //h[i][j], column j of the Hessenberg matrix
+	vector<double> cs(k), sn(k), g(k + 1), w, y(k);
+	bool first = true;
+
+	while (st.iterations < opt.maxIter) {
+		residual(a, b, x, v[0], pool);
+		double beta = norm(v[0]);
+		if (!first)
+			st.residuals.back() = beta / bnorm;
+		first = false;
+		if (beta / bnorm <= opt.tol || beta == 0.0)
+			return;
+		for (size_t i = 0; i < n; ++i)
+			v[0][i] /= beta;
+		fill(g.begin(), g.end(), 0.0);
+		g[0] = beta;
+
+		size_t j = 0;
+		for (; j < k && st.iterations < opt.maxIter; ) {
+			m.apply(v[j], z[j]);
+			spmv(a, z[j], w, pool);
+			//modified Gram-Schmidt
+			for (size_t i = 0; i <= j; ++i) {
+				h[i][j] = dot(w, v[i]);
+				for (size_t t = 0; t < n; ++t)
+					w[t] -= h[i][j] * v[i][t];
+			}
+			h[j + 1][j] = norm(w);
+			v[j + 1].resize(n);
+			if (h[j + 1][j] != 0.0)
+				for (size_t t = 0; t < n; ++t)
+					v[j + 1][t] = w[t] / h[j + 1][j];
+
+			for (size_t i = 0; i < j; ++i) {
+				double tmp = cs[i] * h[i][j] + sn[i] * h[i + 1][j];
+				h[i + 1][j] = -sn[i] * h[i][j] + cs[i] * h[i + 1][j];
+				h[i][j] = tmp;
+			}
+			double d = hypot(h[j][j], h[j + 1][j]);
+			cs[j] = d == 0.0 ? 1.0 : h[j][j] / d;
+			sn[j] = d == 0.0 ? 0.0 : h[j + 1][j] / d;
+			h[j][j] = d;
+			h[j + 1][j] = 0.0;
+			g[j + 1] = -sn[j] * g[j];
+			g[j] *= cs[j];
+
+			++j;
+			++st.iterations;
+			st.residuals.push_back(fabs(g[j]) / bnorm);
+			if (st.residuals.back() <= opt.tol || d == 0.0)
+				break;
+		}
+
+		//x += Z y with H y = g on the j columns built
+		for (size_t i = j; i-- > 0; ) {
+			double s = g[i];
+			for (size_t t = i + 1; t < j; ++t)
+				s -= h[i][t] * y[t];
+			y[i] = h[i][i] == 0.0 ? 0.0 : s / h[i][i];
+		}
+		for (size_t i = 0; i < j; ++i)
+			for (size_t t = 0; t < n; ++t)
+				x[t] += y[i] * z[i][t];
+		if (j == 0)
+			return;
+	}
+}
+
+//right preconditioned BiCGSTAB
+template <class Mat>
+static void bicgstab(const Mat& a, const vector<double>& b, vector<double>& x, const Precond& m,
+	const IterativeOptions& opt, double bnorm, IterativeStats& st, ThreadPool* pool)
+{
+	size_t n = b.size();
+	vector<double> r, r0, p(n, 0.0), v(n, 0.0), s(n), t, ph, sh;
+	residual(a, b, x, r, pool);
+	r0 = r;
+	double rho = 1, alpha = 1, omega = 1;
+	while (st.iterations < opt.maxIter && st.residuals.back() > opt.tol) {
+		double rhonew = dot(r0, r);
+		if (rhonew == 0.0 || omega == 0.0)
+			return; //breakdown
+		double beta = (rhonew / rho) * (alpha / omega);
+		rho = rhonew;
+		for (size_t i = 0; i < n; ++i)
+			p[i] = r[i] + beta * (p[i] - omega * v[i]);
+		m.apply(p, ph);
+		spmv(a, ph, v, pool);
+		double r0v = dot(r0, v);
+		if (r0v == 0.0)
+			return;
+		alpha = rho / r0v;
+		for (size_t i = 0; i < n; ++i)
+			s[i] = r[i] - alpha * v[i];
+		++st.iterations;
+		if (norm(s) / bnorm <= opt.tol) {
+			for (size_t i = 0; i < n; ++i)
+				x[i] += alpha * ph[i];
+			st.residuals.push_back(norm(s) / bnorm);
+			return;
+		}
+		m.apply(s, sh);
+		spmv(a, sh, t, pool);
+		double tt = dot(t, t);
+		omega = tt == 0.0 ? 0.0 : dot(t, s) / tt;
+		for (size_t i = 0; i < n; ++i) {
+			x[i] += alpha * ph[i] + omega * sh[i];
+			r[i] = s[i] - omega * t[i];
+		}
+		st.residuals.push_back(norm(r) / bnorm);
+	}
+}
+
+template <class Mat>
+static IterativeStats krylov(const Mat& a, const vector<double>& b, vector<double>& x, const IterativeOptions& opt,
+	ThreadPool* pool)
+{
+	IterativeStats st;
+	size_t n = b.size();
+	if (x.size() != n)
+		x.assign(n, 0.0);
+
+	double bnorm = norm(b);
+	if (bnorm == 0.0) {
+		x.assign(n, 0.0);
+		st.converged = true;
+		st.residuals.push_back(0.0);
+		return st;
+	}
+	vector<double> r;
+	residual(a, b, x, r, pool);
+	st.residuals.push_back(norm(r) / bnorm);
+
+	//The recurrences drift from the true residual in floating point, so a
+	//method that thinks it is done is checked against b - Ax and restarted
+	//from there if it is not, for as long as it keeps making iterations.
+	Precond m(a, opt.precond);
+	while (true) {
+		size_t before = st.iterations;
+		if (opt.method == SOLVE_CG)
+			cg(a, b, x, m, opt, bnorm, st, pool);
+		else if (opt.method == SOLVE_GMRES)
+			gmres(a, b, x, m, opt, bnorm, st, pool);
+		else
+			bicgstab(a, b, x, m, opt, bnorm, st, pool);
+
+		residual(a, b, x, r, pool);
+		st.residuals.back() = norm(r) / bnorm;
+		st.converged = st.residuals.back() <= opt.tol;
+		if (st.converged || st.iterations == before || st.iterations >= opt.maxIter)
+			return st;
+	}
+}
+
+IterativeStats iterativeSolve(const SparseMatrix& a, const std::vector<double>& b, std::vector<double>& x,
+	const IterativeOptions& opt, ThreadPool* pool)
+{
+	return krylov(a, b, x, opt, pool);
+}
+
+IterativeStats iterativeSolve(const Matrix& a, const std::vector<double>& b, std::vector<double>& x,
+	const IterativeOptions& opt, ThreadPool* pool)
+{
+	return krylov(a, b, x, opt, pool);
+}
@@ -0,0 +1,49 @@
+#ifndef __ITERATIVE_H__
+#define __ITERATIVE_H__
+#include <cstddef>
+#include <vector>
+#include "matrix.h"
+#include "sparse.h"
+#include "threadpool.h"
+
+enum SolveMethod {
+	SOLVE_DIRECT,   //LU (dense) or sparse elimination, the default
+	SOLVE_CG,       //conjugate gradient, symmetric positive definite only
+	SOLVE_GMRES,    //restarted GMRES, any nonsingular square system
+	SOLVE_BICGSTAB  //BiCGSTAB, any nonsingular square system
+};
+
+enum Preconditioner { PRECOND_NONE, PRECOND_JACOBI, PRECOND_ILU0 };
+
+struct IterativeOptions {
+	IterativeOptions() : method(SOLVE_DIRECT), precond(PRECOND_JACOBI), tol(1e-10), maxIter(1000), restart(50),
+		classify(false) {}
+
+	SolveMethod method;
+	Preconditioner precond;
+	double tol; //stop once ||b - Ax|| <= tol * ||b||
+	size_t maxIter;
+	size_t restart; //GMRES only, Krylov vectors kept between restarts
+	bool classify; //System only: count the solutions of a converged run by elimination (a full direct solve)
+};
+
+//convergence telemetry of the last iterative solve
+struct IterativeStats {
+	IterativeStats() : converged(false), iterations(0), fellBack(false) {}
+
+	bool converged;
+	size_t iterations;
+	std::vector<double> residuals; //||b - Ax|| / ||b|| before the first and after every iteration
+	bool fellBack; //System only: did not converge, the direct solver was used instead
+};
+
+//Solves the square system a x = b starting from the x passed in (resized and
+//zeroed if it has the wrong length). Matrix-vector products are split over
+//pool by rows when one is given.
+IterativeStats iterativeSolve(const SparseMatrix& a, const std::vector<double>& b, std::vector<double>& x,
+	const IterativeOptions& opt, ThreadPool* pool);
+//the same on a dense a, multiplied in place; ILU(0) becomes Jacobi there
+IterativeStats iterativeSolve(const Matrix& a, const std::vector<double>& b, std::vector<double>& x,
+	const IterativeOptions& opt, ThreadPool* pool);
+
+#endif
@@ -0,0 +1,483 @@
+#include <atomic>
+#include "kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+//---- portable versions ------------------------------------------------------
+
+template <typename T>
+static void axpyScalar(T* __restrict y, const T* __restrict x, T c, size_t n)
+{
+	for (size_t j = 0; j < n; ++j)
+		y[j] -= x[j] * c;
+}
+
+template <typename T>
+static void rankUpdateScalar(T* const* a, size_t nrows, const T* l, size_t r,
+	const T* u, size_t ustride, size_t w)
+{
+	for (size_t i = 0; i < nrows; ++i) {
+		T* __restrict ai = a[i];
+		const T* li = l + i * r;
+		for (size_t p = 0; p < r; ++p) {
+			const T* __restrict up = u + p * ustride;
+			T c = li[p];
+			for (size_t j = 0; j < w; ++j)
+				ai[j] -= up[j] * c;
+		}
+	}
+}
+
+#ifdef HAVE_X86_KERNELS
+
+//---- AVX2 + FMA -------------------------------------------------------------
+
+__attribute__((target("avx2,fma")))
+static void axpyAvx2(double* y, const double* x, double c, size_t n)
+{
+	__m256d vc = _mm256_set1_pd(c);
+	size_t j = 0;
+	for (; j + 8 <= n; j += 8) {
+		__m256d y0 = _mm256_fnmadd_pd(_mm256_loadu_pd(x + j), vc, _mm256_loadu_pd(y + j));
+		__m256d y1 = _mm256_fnmadd_pd(_mm256_loadu_pd(x + j + 4), vc, _mm256_loadu_pd(y + j + 4));
+		_mm256_storeu_pd(y + j, y0);
+		_mm256_storeu_pd(y + j + 4, y1);
+	}
+	for (; j < n; ++j)
+		y[j] = __builtin_fma(-x[j], c, y[j]);
+}
+
+//one row: 8 columns per step, accumulated over p in registers
+__attribute__((target("avx2,fma")))
+static void rankUpdate1Avx2(double* a, const double* l, size_t r, const double* u, size_t ustride, size_t w)
+{
+	size_t j = 0;
+	for (; j + 8 <= w; j += 8) {
+		__m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+		const double* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride) {
+			__m256d lp = _mm256_broadcast_sd(l + p);
+			c0 = _mm256_fmadd_pd(lp, _mm256_loadu_pd(up), c0);
+			c1 = _mm256_fmadd_pd(lp, _mm256_loadu_pd(up + 4), c1);
+		}
+		_mm256_storeu_pd(a + j, _mm256_sub_pd(_mm256_loadu_pd(a + j), c0));
+		_mm256_storeu_pd(a + j + 4, _mm256_sub_pd(_mm256_loadu_pd(a + j + 4), c1));
+	}
+	for (; j < w; ++j) {
+		double s = 0;
+		for (size_t p = 0; p < r; ++p)
+			s = __builtin_fma(l[p], u[p * ustride + j], s);
+		a[j] -= s;
+	}
+}
+
+//four rows x 8 columns, 8 accumulators; each U load feeds four FMAs
+__attribute__((target("avx2,fma")))
+static void rankUpdate4Avx2(double* const* a, const double* l, size_t r, const double* u, size_t ustride, size_t w)
+{
+	double* a0 = a[0];
+	double* a1 = a[1];
+	double* a2 = a[2];
+	double* a3 = a[3];
+	const double* l0 = l;
+	const double* l1 = l + r;
+	const double* l2 = l + 2 * r;
+	const double* l3 = l + 3 * r;
+	size_t j = 0;
+	for (; j + 8 <= w; j += 8) {
+		__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+		__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+		__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+		__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+		const double* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride) {
+			__m256d u0 = _mm256_loadu_pd(up);
+			__m256d u1 = _mm256_loadu_pd(up + 4);
+			__m256d lp = _mm256_broadcast_sd(l0 + p);
+			c00 = _mm256_fmadd_pd(lp, u0, c00);
+			c01 = _mm256_fmadd_pd(lp, u1, c01);
+			lp = _mm256_broadcast_sd(l1 + p);
+			c10 = _mm256_fmadd_pd(lp, u0, c10);
+			c11 = _mm256_fmadd_pd(lp, u1, c11);
+			lp = _mm256_broadcast_sd(l2 + p);
+			c20 = _mm256_fmadd_pd(lp, u0, c20);
+			c21 = _mm256_fmadd_pd(lp, u1, c21);
+			lp = _mm256_broadcast_sd(l3 + p);
+			c30 = _mm256_fmadd_pd(lp, u0, c30);
+			c31 = _mm256_fmadd_pd(lp, u1, c31);
+		}
+		_mm256_storeu_pd(a0 + j, _mm256_sub_pd(_mm256_loadu_pd(a0 + j), c00));
+		_mm256_storeu_pd(a0 + j + 4, _mm256_sub_pd(_mm256_loadu_pd(a0 + j + 4), c01));
+		_mm256_storeu_pd(a1 + j, _mm256_sub_pd(_mm256_loadu_pd(a1 + j), c10));
+		_mm256_storeu_pd(a1 + j + 4, _mm256_sub_pd(_mm256_loadu_pd(a1 + j + 4), c11));
+		_mm256_storeu_pd(a2 + j, _mm256_sub_pd(_mm256_loadu_pd(a2 + j), c20));
+		_mm256_storeu_pd(a2 + j + 4, _mm256_sub_pd(_mm256_loadu_pd(a2 + j + 4), c21));
+		_mm256_storeu_pd(a3 + j, _mm256_sub_pd(_mm256_loadu_pd(a3 + j), c30));
+		_mm256_storeu_pd(a3 + j + 4, _mm256_sub_pd(_mm256_loadu_pd(a3 + j + 4), c31));
+	}
+	if (j < w)
+		for (size_t i = 0; i < 4; ++i)
+			rankUpdate1Avx2(a[i] + j, l + i * r, r, u + j, ustride, w - j);
+}
+
+__attribute__((target("avx2,fma")))
+static void rankUpdateAvx2(double* const* a, size_t nrows, const double* l, size_t r,
+	const double* u, size_t ustride, size_t w)
+{
+	if (nrows == 4) {
+		rankUpdate4Avx2(a, l, r, u, ustride, w);
+		return;
+	}
+	for (size_t i = 0; i < nrows; ++i)
+		rankUpdate1Avx2(a[i], l + i * r, r, u, ustride, w);
+}
+
+//---- AVX2 + FMA, float ------------------------------------------------------
+
+__attribute__((target("avx2,fma")))
+static void axpyfAvx2(float* y, const float* x, float c, size_t n)
+{
+	__m256 vc = _mm256_set1_ps(c);
+	size_t j = 0;
+	for (; j + 16 <= n; j += 16) {
+		__m256 y0 = _mm256_fnmadd_ps(_mm256_loadu_ps(x + j), vc, _mm256_loadu_ps(y + j));
+		__m256 y1 = _mm256_fnmadd_ps(_mm256_loadu_ps(x + j + 8), vc, _mm256_loadu_ps(y + j + 8));
+		_mm256_storeu_ps(y + j, y0);
+		_mm256_storeu_ps(y + j + 8, y1);
+	}
+	for (; j < n; ++j)
+		y[j] = __builtin_fmaf(-x[j], c, y[j]);
+}
+
+__attribute__((target("avx2,fma")))
+static void rankUpdate1fAvx2(float* a, const float* l, size_t r, const float* u, size_t ustride, size_t w)
+{
+	size_t j = 0;
+	for (; j + 16 <= w; j += 16) {
+		__m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps();
+		const float* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride) {
+			__m256 lp = _mm256_broadcast_ss(l + p);
+			c0 = _mm256_fmadd_ps(lp, _mm256_loadu_ps(up), c0);
+			c1 = _mm256_fmadd_ps(lp, _mm256_loadu_ps(up + 8), c1);
+		}
+		_mm256_storeu_ps(a + j, _mm256_sub_ps(_mm256_loadu_ps(a + j), c0));
+		_mm256_storeu_ps(a + j + 8, _mm256_sub_ps(_mm256_loadu_ps(a + j + 8), c1));
+	}
+	for (; j < w; ++j) {
+		float s = 0;
+		for (size_t p = 0; p < r; ++p)
+			s = __builtin_fmaf(l[p], u[p * ustride + j], s);
+		a[j] -= s;
+	}
+}
+
+//four rows x 16 columns, same register layout as the double version
+__attribute__((target("avx2,fma")))
+static void rankUpdate4fAvx2(float* const* a, const float* l, size_t r, const float* u, size_t ustride, size_t w)
+{
+	float* a0 = a[0];
+	float* a1 = a[1];
+	float* a2 = a[2];
+	float* a3 = a[3];
+	const float* l0 = l;
+	const float* l1 = l + r;
+	const float* l2 = l + 2 * r;
+	const float* l3 = l + 3 * r;
+	size_t j = 0;
+	for (; j + 16 <= w; j += 16) {
+		__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+		__m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+		__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+		__m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+		const float* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride) {
+			__m256 u0 = _mm256_loadu_ps(up);
+			__m256 u1 = _mm256_loadu_ps(up + 8);
+			__m256 lp = _mm256_broadcast_ss(l0 + p);
+			c00 = _mm256_fmadd_ps(lp, u0, c00);
+			c01 = _mm256_fmadd_ps(lp, u1, c01);
+			lp = _mm256_broadcast_ss(l1 + p);
+			c10 = _mm256_fmadd_ps(lp, u0, c10);
+			c11 = _mm256_fmadd_ps(lp, u1, c11);
+			lp = _mm256_broadcast_ss(l2 + p);
+			c20 = _mm256_fmadd_ps(lp, u0, c20);
+			c21 = _mm256_fmadd_ps(lp, u1, c21);
+			lp = _mm256_broadcast_ss(l3 + p);
+			c30 = _mm256_fmadd_ps(lp, u0, c30);
+			c31 = _mm256_fmadd_ps(lp, u1, c31);
+		}
+		_mm256_storeu_ps(a0 + j, _mm256_sub_ps(_mm256_loadu_ps(a0 + j), c00));
+		_mm256_storeu_ps(a0 + j + 8, _mm256_sub_ps(_mm256_loadu_ps(a0 + j + 8), c01));
+		_mm256_storeu_ps(a1 + j, _mm256_sub_ps(_mm256_loadu_ps(a1 + j), c10));
+		_mm256_storeu_ps(a1 + j + 8, _mm256_sub_ps(_mm256_loadu_ps(a1 + j + 8), c11));
+		_mm256_storeu_ps(a2 + j, _mm256_sub_ps(_mm256_loadu_ps(a2 + j), c20));
+		_mm256_storeu_ps(a2 + j + 8, _mm256_sub_ps(_mm256_loadu_ps(a2 + j + 8), c21));
+		_mm256_storeu_ps(a3 + j, _mm256_sub_ps(_mm256_loadu_ps(a3 + j), c30));
+		_mm256_storeu_ps(a3 + j + 8, _mm256_sub_ps(_mm256_loadu_ps(a3 + j + 8), c31));
+	}
+	if (j < w)
+		for (size_t i = 0; i < 4; ++i)
+			rankUpdate1fAvx2(a[i] + j, l + i * r, r, u + j, ustride, w - j);
+}
+
+__attribute__((target("avx2,fma")))
+static void rankUpdatefAvx2(float* const* a, size_t nrows, const float* l, size_t r,
+	const float* u, size_t ustride, size_t w)
+{
+	if (nrows == 4) {
+		rankUpdate4fAvx2(a, l, r, u, ustride, w);
+		return;
+	}
+	for (size_t i = 0; i < nrows; ++i)
+		rankUpdate1fAvx2(a[i], l + i * r, r, u, ustride, w);
+}
+
+//---- AVX-512 ----------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static void axpyAvx512(double* y, const double* x, double c, size_t n)
+{
+	__m512d vc = _mm512_set1_pd(c);
+	size_t j = 0;
+	for (; j + 8 <= n; j += 8)
+		_mm512_storeu_pd(y + j, _mm512_fnmadd_pd(_mm512_loadu_pd(x + j), vc, _mm512_loadu_pd(y + j)));
+	if (j < n) {
+		__mmask8 m = (__mmask8)((1u << (n - j)) - 1);
+		__m512d yv = _mm512_fnmadd_pd(_mm512_maskz_loadu_pd(m, x + j), vc, _mm512_maskz_loadu_pd(m, y + j));
+		_mm512_mask_storeu_pd(y + j, m, yv);
+	}
+}
+
+//one row, 8 columns per step with a masked tail
+__attribute__((target("avx512f")))
+static void rankUpdate1Avx512(double* a, const double* l, size_t r, const double* u, size_t ustride, size_t w)
+{
+	for (size_t j = 0; j < w; j += 8) {
+		__mmask8 m = w - j >= 8 ? (__mmask8)0xff : (__mmask8)((1u << (w - j)) - 1);
+		__m512d c = _mm512_setzero_pd();
+		const double* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride)
+			c = _mm512_fmadd_pd(_mm512_set1_pd(l[p]), _mm512_maskz_loadu_pd(m, up), c);
+		_mm512_mask_storeu_pd(a + j, m, _mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + j), c));
+	}
+}
+
+//four rows x 16 columns, 8 accumulators
+__attribute__((target("avx512f")))
+static void rankUpdate4Avx512(double* const* a, const double* l, size_t r, const double* u, size_t ustride, size_t w)
+{
+	double* a0 = a[0];
+	double* a1 = a[1];
+	double* a2 = a[2];
+	double* a3 = a[3];
+	const double* l0 = l;
+	const double* l1 = l + r;
+	const double* l2 = l + 2 * r;
+	const double* l3 = l + 3 * r;
+	size_t j = 0;
+	for (; j + 16 <= w; j += 16) {
+		__m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+		__m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+		__m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+		__m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+		const double* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride) {
+			__m512d u0 = _mm512_loadu_pd(up);
+			__m512d u1 = _mm512_loadu_pd(up + 8);
+			__m512d lp = _mm512_set1_pd(l0[p]);
+			c00 = _mm512_fmadd_pd(lp, u0, c00);
+			c01 = _mm512_fmadd_pd(lp, u1, c01);
+			lp = _mm512_set1_pd(l1[p]);
+			c10 = _mm512_fmadd_pd(lp, u0, c10);
+			c11 = _mm512_fmadd_pd(lp, u1, c11);
+			lp = _mm512_set1_pd(l2[p]);
+			c20 = _mm512_fmadd_pd(lp, u0, c20);
+			c21 = _mm512_fmadd_pd(lp, u1, c21);
+			lp = _mm512_set1_pd(l3[p]);
+			c30 = _mm512_fmadd_pd(lp, u0, c30);
+			c31 = _mm512_fmadd_pd(lp, u1, c31);
+		}
+		_mm512_storeu_pd(a0 + j, _mm512_sub_pd(_mm512_loadu_pd(a0 + j), c00));
+		_mm512_storeu_pd(a0 + j + 8, _mm512_sub_pd(_mm512_loadu_pd(a0 + j + 8), c01));
+		_mm512_storeu_pd(a1 + j, _mm512_sub_pd(_mm512_loadu_pd(a1 + j), c10));
+		_mm512_storeu_pd(a1 + j + 8, _mm512_sub_pd(_mm512_loadu_pd(a1 + j + 8), c11));
+		_mm512_storeu_pd(a2 + j, _mm512_sub_pd(_mm512_loadu_pd(a2 + j), c20));
+		_mm512_storeu_pd(a2 + j + 8, _mm512_sub_pd(_mm512_loadu_pd(a2 + j + 8), c21));
+		_mm512_storeu_pd(a3 + j, _mm512_sub_pd(_mm512_loadu_pd(a3 + j), c30));
+		_mm512_storeu_pd(a3 + j + 8, _mm512_sub_pd(_mm512_loadu_pd(a3 + j + 8), c31));
+	}
+	if (j < w)
+		for (size_t i = 0; i < 4; ++i)
+			rankUpdate1Avx512(a[i] + j, l + i * r, r, u + j, ustride, w - j);
+}
+
+__attribute__((target("avx512f")))
+static void rankUpdateAvx512(double* const* a, size_t nrows, const double* l, size_t r,
+	const double* u, size_t ustride, size_t w)
+{
+	if (nrows == 4) {
+		rankUpdate4Avx512(a, l, r, u, ustride, w);
+		return;
+	}
+	for (size_t i = 0; i < nrows; ++i)
+		rankUpdate1Avx512(a[i], l + i * r, r, u, ustride, w);
+}
+
+//---- AVX-512, float ---------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static void axpyfAvx512(float* y, const float* x, float c, size_t n)
+{
+	__m512 vc = _mm512_set1_ps(c);
+	for (size_t j = 0; j < n; j += 16) {
+		__mmask16 m = n - j >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (n - j)) - 1);
+		__m512 yv = _mm512_fnmadd_ps(_mm512_maskz_loadu_ps(m, x + j), vc, _mm512_maskz_loadu_ps(m, y + j));
+		_mm512_mask_storeu_ps(y + j, m, yv);
+	}
+}
+
+__attribute__((target("avx512f")))
+static void rankUpdate1fAvx512(float* a, const float* l, size_t r, const float* u, size_t ustride, size_t w)
+{
+	for (size_t j = 0; j < w; j += 16) {
+		__mmask16 m = w - j >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (w - j)) - 1);
+		__m512 c = _mm512_setzero_ps();
+		const float* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride)
+			c = _mm512_fmadd_ps(_mm512_set1_ps(l[p]), _mm512_maskz_loadu_ps(m, up), c);
+		_mm512_mask_storeu_ps(a + j, m, _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + j), c));
+	}
+}
+
+//four rows x 32 columns, 8 accumulators
+__attribute__((target("avx512f")))
+static void rankUpdate4fAvx512(float* const* a, const float* l, size_t r, const float* u, size_t ustride, size_t w)
+{
+	float* a0 = a[0];
+	float* a1 = a[1];
+	float* a2 = a[2];
+	float* a3 = a[3];
+	const float* l0 = l;
+	const float* l1 = l + r;
+	const float* l2 = l + 2 * r;
+	const float* l3 = l + 3 * r;
+	size_t j = 0;
+	for (; j + 32 <= w; j += 32) {
+		__m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+		__m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+		__m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+		__m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+		const float* up = u + j;
+		for (size_t p = 0; p < r; ++p, up += ustride) {
+			__m512 u0 = _mm512_loadu_ps(up);
+			__m512 u1 = _mm512_loadu_ps(up + 16);
+			__m512 lp = _mm512_set1_ps(l0[p]);
+			c00 = _mm512_fmadd_ps(lp, u0, c00);
+			c01 = _mm512_fmadd_ps(lp, u1, c01);
+			lp = _mm512_set1_ps(l1[p]);
+			c10 = _mm512_fmadd_ps(lp, u0, c10);
+			c11 = _mm512_fmadd_ps(lp, u1, c11);
+			lp = _mm512_set1_ps(l2[p]);
+			c20 = _mm512_fmadd_ps(lp, u0, c20);
+			c21 = _mm512_fmadd_ps(lp, u1, c21);
+			lp = _mm512_set1_ps(l3[p]);
+			c30 = _mm512_fmadd_ps(lp, u0, c30);
+			c31 = _mm512_fmadd_ps(lp, u1, c31);
+		}
+		_mm512_storeu_ps(a0 + j, _mm512_sub_ps(_mm512_loadu_ps(a0 + j), c00));
+		_mm512_storeu_ps(a0 + j + 16, _mm512_sub_ps(_mm512_loadu_ps(a0 + j + 16), c01));
+		_mm512_storeu_ps(a1 + j, _mm512_sub_ps(_mm512_loadu_ps(a1 + j), c10));
+		_mm512_storeu_ps(a1 + j + 16, _mm512_sub_ps(_mm512_loadu_ps(a1 + j + 16), c11));
+		_mm512_storeu_ps(a2 + j, _mm512_sub_ps(_mm512_loadu_ps(a2 + j), c20));
+		_mm512_storeu_ps(a2 + j + 16, _mm512_sub_ps(_mm512_loadu_ps(a2 + j + 16), c21));
+		_mm512_storeu_ps(a3 + j, _mm512_sub_ps(_mm512_loadu_ps(a3 + j), c30));
+		_mm512_storeu_ps(a3 + j + 16, _mm512_sub_ps(_mm512_loadu_ps(a3 + j + 16), c31));
+	}
+	if (j < w)
+		for (size_t i = 0; i < 4; ++i)
+			rankUpdate1fAvx512(a[i] + j, l + i * r, r, u + j, ustride, w - j);
+}
+
+__attribute__((target("avx512f")))
+static void rankUpdatefAvx512(float* const* a, size_t nrows, const float* l, size_t r,
+	const float* u, size_t ustride, size_t w)
+{
+	if (nrows == 4) {
+		rankUpdate4fAvx512(a, l, r, u, ustride, w);
+		return;
+	}
+	for (size_t i = 0; i < nrows; ++i)
+		rankUpdate1fAvx512(a[i], l + i * r, r, u, ustride, w);
+}
+
+#endif //HAVE_X86_KERNELS
+
+//---- dispatch ---------------------------------------------------------------
+
+static const Kernels SCALAR_KERNELS = { KERNEL_SCALAR, "scalar", axpyScalar<double>, rankUpdateScalar<double>,
+	axpyScalar<float>, rankUpdateScalar<float> };
+#ifdef HAVE_X86_KERNELS
+static const Kernels AVX2_KERNELS = { KERNEL_AVX2, "avx2", axpyAvx2, rankUpdateAvx2, axpyfAvx2, rankUpdatefAvx2 };
+static const Kernels AVX512_KERNELS = { KERNEL_AVX512, "avx512", axpyAvx512, rankUpdateAvx512, axpyfAvx512, rankUpdatefAvx512 };
+#endif
+
+bool kernelSupported(KernelIsa isa)
+{
+	switch (isa) {
+	case KERNEL_SCALAR:
+		return true;
+#ifdef HAVE_X86_KERNELS
+	case KERNEL_AVX2:
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case KERNEL_AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+const Kernels& kernelsFor(KernelIsa isa)
+{
+#ifdef HAVE_X86_KERNELS
+	if (isa == KERNEL_AVX512)
+		return AVX512_KERNELS;
+	if (isa == KERNEL_AVX2)
+		return AVX2_KERNELS;
+#endif
+	(void) isa;
+	return SCALAR_KERNELS;
+}
+
+static const Kernels* bestKernels()
+{
+	if (kernelSupported(KERNEL_AVX512))
+		return &kernelsFor(KERNEL_AVX512);
+	if (kernelSupported(KERNEL_AVX2))
+		return &kernelsFor(KERNEL_AVX2);
+	return &SCALAR_KERNELS;
+}
+
+static atomic<const Kernels*> g_active(NULL);
+
+const Kernels& activeKernels()
+{
+	const Kernels* k = g_active.load(memory_order_acquire);
+	if (!k) {
+		k = bestKernels();
+		g_active.store(k, memory_order_release);
+	}
+	return *k;
+}
+
+void setActiveKernels(KernelIsa isa)
+{
+	if (kernelSupported(isa))
+		g_active.store(&kernelsFor(isa), memory_order_release);
+}
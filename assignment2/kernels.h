@@ -0,0 +1,35 @@
+#ifndef __KERNELS_H__
+#define __KERNELS_H__
+#include <cstddef>
+
+//Row elimination kernels used by System::solve(). Every routine exists as
+//plain C++ and, on x86-64, as AVX2+FMA and AVX-512 versions compiled with
+//per-function target attributes, so the binary itself does not need
+//-mavx2. The widest one the CPU supports is picked on first use.
+
+enum KernelIsa { KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512 };
+
+struct Kernels {
+	KernelIsa isa;
+	const char* name;
+
+	//y[j] -= x[j] * c for j < n
+	void (*axpy)(double* y, const double* x, double c, size_t n);
+
+	//a[i][j] -= sum over p < r of l[i * r + p] * u[p * ustride + j]
+	//for the nrows (at most 4) rows a[0..nrows) and j < w
+	void (*rankUpdate)(double* const* a, size_t nrows, const double* l, size_t r,
+		const double* u, size_t ustride, size_t w);
+
+	//the same two in single precision, for the mixed precision solve
+	void (*axpyf)(float* y, const float* x, float c, size_t n);
+	void (*rankUpdatef)(float* const* a, size_t nrows, const float* l, size_t r,
+		const float* u, size_t ustride, size_t w);
+};
+
+bool kernelSupported(KernelIsa isa);
+const Kernels& kernelsFor(KernelIsa isa); //isa must be supported
+const Kernels& activeKernels(); //widest supported, unless overridden
+void setActiveKernels(KernelIsa isa); //for benchmarks; ignored if unsupported
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef __MATRIX_H__
+#define __MATRIX_H__
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+//Contiguous row-major matrix. Every row is padded out to a whole number of
+//cache lines and the block itself is cache line aligned, so row i starts at
+//data() + i * stride() on a line boundary and no two rows share a line.
+template <typename T>
+class DenseMatrix {
+public:
+	static const size_t ALIGN = 64;
+	static const size_t LANES = ALIGN / sizeof(T); //elements per cache line
+
+	DenseMatrix() : m_rows(0), m_cols(0), m_stride(0), m_data(NULL) {}
+	DenseMatrix(size_t rows, size_t cols) : m_rows(0), m_cols(0), m_stride(0), m_data(NULL)
+	{
+		resize(rows, cols);
+	}
+	DenseMatrix(const DenseMatrix& other) : m_rows(0), m_cols(0), m_stride(0), m_data(NULL)
+	{
+		resize(other.m_rows, other.m_cols);
+		if (m_data)
+			memcpy(m_data, other.m_data, m_rows * m_stride * sizeof(T));
+	}
+	DenseMatrix(DenseMatrix&& other) : m_rows(0), m_cols(0), m_stride(0), m_data(NULL)
+	{
+		swap(other);
+	}
+	DenseMatrix& operator=(DenseMatrix other)
+	{
+		swap(other);
+		return *this;
+	}
+	~DenseMatrix() { free(m_data); }
+
+	//reallocates and zero fills, existing contents are not kept
+	void resize(size_t rows, size_t cols)
+	{
+		free(m_data);
+		m_data = NULL;
+		m_rows = rows;
+		m_cols = cols;
+		m_stride = (cols + LANES - 1) / LANES * LANES;
+		size_t bytes = m_rows * m_stride * sizeof(T);
+		if (bytes == 0)
+			return;
+		void* p = NULL;
+		if (posix_memalign(&p, ALIGN, bytes) != 0)
+			throw std::bad_alloc();
+		m_data = static_cast<T*>(p);
+		memset(m_data, 0, bytes);
+	}
+
+	void swap(DenseMatrix& other)
+	{
+		std::swap(m_rows, other.m_rows);
+		std::swap(m_cols, other.m_cols);
+		std::swap(m_stride, other.m_stride);
+		std::swap(m_data, other.m_data);
+	}
+
+	//swaps two whole rows, padding included
+	void swapRows(size_t a, size_t b)
+	{
+		if (a == b)
+			return;
+		T* ra = (*this)[a];
+		T* rb = (*this)[b];
+		for (size_t j = 0; j < m_stride; ++j)
+			std::swap(ra[j], rb[j]);
+	}
+
+	T* operator[](size_t i) { return m_data + i * m_stride; }
+	const T* operator[](size_t i) const { return m_data + i * m_stride; }
+
+	size_t rows() const { return m_rows; }
+	size_t cols() const { return m_cols; }
+	size_t stride() const { return m_stride; }
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+
+private:
+	size_t m_rows, m_cols, m_stride;
+	T* m_data;
+};
+
+typedef DenseMatrix<double> Matrix;
+
+#endif
@@ -1,230 +1,597 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <vector>
 #include <string>
-#include <utility>
+#include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "elements.h"
+#include "search.h"
+#include "store.h"
 
 using namespace std;
 
-struct Element
+// g++ -std=c++17 -O2 periodic.cpp elements.cpp search.cpp store.cpp -o periodic
+//
+//   ./periodic                      ask for elements one at a time
+//   ./periodic search [text]        values of any column (name, symbol,
+//                                   phase, type) starting with text, or
+//                                   else close to it
+//   ./periodic where [predicate...] elements matching every predicate, as
+//                                   phase=solid, type="noble gas|halogen",
+//                                   mass=50:100 or number=:20 (inclusive,
+//                                   either end open), one TSV line each
+//   ./periodic batch [file] [json]  one query per line from file (or -,
+//                                   stdin by default), one result line
+//                                   each as TSV or JSON lines
+//   ./periodic bench [queries]      queries/s of batch mode against the
+//                                   interactive loop, and time per search
+//                                   and where query
+
+void display_element(const Element &elem, std::ostream &out)
 {
-	Element() : symbol(), name(), number(0), atomic_mass(0.0), phase(), type() {}
+	out << "Symbol:       " << elem.symbol << std::endl;
+	out << "Name:         " << elem.name << std::endl;
+	out << "Atomic Number:" << elem.number << std::endl;
+	out << "Atomic Mass:  " << elem.atomic_mass << std::endl;
+	out << "Phase:        " << elem.phase << std::endl;
+	out << "Type:         " << elem.type << std::endl;
+}
 
-	std::string symbol; // e.g., "H", "He"
-	std::string name;		// e.g., "Hydrogen", "Helium"
-	int number;					// e.g., 1, 2
-	double atomic_mass; // e.g., 1.008, 4.0026
-	std::string phase;	// phase at room temp e.g., gas, liquid, solid
-	std::string type;		// e.g., "transitional metals", "noble gas"
-};
+static bool is_space(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
 
-// Comparator for sorting the index vectors
-struct CompClass
+static bool all_digits(const char *s, size_t len)
 {
-	bool operator()(const std::pair<std::string, int> &a, const std::pair<std::string, int> &b)
+	for (size_t i = 0; i < len; ++i)
 	{
-		return a.first < b.first;
+		if (s[i] < '0' || s[i] > '9')
+		{
+			return false;
+		}
 	}
-} comp;
+	return len > 0;
+}
 
-int index_find(const std::vector<std::pair<std::string, int> > &index, const std::string &key)
+// a number, symbol (one or two letters) or name (three or more), in any case
+const Element *lookup(const char *s, size_t len)
 {
-	int left = 0;
-	int right = static_cast<int>(index.size()) - 1;
-	while (left <= right)
+	if (all_digits(s, len))
 	{
-		int mid = left + (right - left) / 2;
-		if (index[mid].first == key)
-		{
-			return index[mid].second;
-		}
-		else if (index[mid].first < key)
-		{
-			left = mid + 1;
-		}
-		else
+		int number = 0;
+		for (size_t i = 0; i < len; ++i)
 		{
-			right = mid - 1;
+			number = std::min(number * 10 + (s[i] - '0'), 1000);
 		}
+		return element_by_number(number);
 	}
-	return -1; // Not found
+	return len <= 2 ? element_by_symbol(s, len) : element_by_name(s, len);
 }
 
-void display_element(const Element &elem)
+// names and symbols, for suggestions
+const ElementSearch &name_search()
 {
-	std::cout << "Symbol:       " << elem.symbol << std::endl;
-	std::cout << "Name:         " << elem.name << std::endl;
-	std::cout << "Atomic Number:" << elem.number << std::endl;
-	std::cout << "Atomic Mass:  " << elem.atomic_mass << std::endl;
-	std::cout << "Phase:        " << elem.phase << std::endl;
-	std::cout << "Type:         " << elem.type << std::endl;
+	static const ElementSearch index({FIELD_NAME, FIELD_SYMBOL});
+	return index;
 }
 
-int main(int argc, char *argv[])
+// up to three elements spelled close to s, as "Name" or "Symbol (Name)"
+std::vector<std::string> suggestions(const char *s, size_t len)
 {
-	std::vector<Element> elements(119);
-	std::vector<std::pair<std::string, int> > name_index;
-	std::vector<std::pair<std::string, int> > symbol_index;
-
-	std::ifstream file("elements.csv");
-	if (!file.is_open())
+	const ElementSearch &index = name_search();
+	SearchHit hits[6];
+	size_t n = index.fuzzy(s, len, hits, 6);
+	std::vector<std::string> names;
+	std::vector<int> seen;
+	for (size_t i = 0; i < n && names.size() < 3; ++i)
 	{
-		std::cerr << "Error: Could not open file 'periodic_table_data.csv'" << std::endl;
-		return 1;
+		size_t count;
+		int number = index.elements(hits[i].key, count)[0];
+		if (std::find(seen.begin(), seen.end(), number) != seen.end())
+		{
+			continue;
+		}
+		seen.push_back(number);
+		std::string name(element_by_number(number)->name);
+		names.push_back(index.field(hits[i].key) == FIELD_NAME ? name : std::string(index.key(hits[i].key)) + " (" + name + ")");
 	}
+	return names;
+}
 
-	// skip header
-	std::string line;
-	std::getline(file, line);
-
-	while (std::getline(file, line))
+void run_interactive(std::istream &in, std::ostream &out)
+{
+	while (true)
 	{
-		std::stringstream ss(line);
-		std::string token;
-
-		Element elem;
-
-		// Atomic Number
-		std::getline(ss, token, ',');
-		elem.number = std::stoi(token);
-
-		// Name
-		std::getline(ss, token, ',');
-		elem.name = token;
-
-		// Symbol
-		std::getline(ss, token, ',');
-		elem.symbol = token;
-
-		// Atomic Mass
-		std::getline(ss, token, ',');
-		elem.atomic_mass = std::stod(token);
+		out << "Enter element number, symbol, name, or 'quit' to exit: ";
+		std::string input;
+		if (!std::getline(in, input))
+		{
+			break;
+		}
 
-		// Phase
-		std::getline(ss, token, ',');
-		elem.phase = token;
+		// trim whitespace
+		input.erase(0, input.find_first_not_of(" \t\n\r\f\v"));
+		input.erase(input.find_last_not_of(" \t\n\r\f\v") + 1);
 
-		// Type
-		std::getline(ss, token, ',');
-		elem.type = token;
+		if (strcasecmp(input.c_str(), "quit") == 0)
+		{
+			break;
+		}
 
-		// Insert into elements vector
-		if (elem.number >= 1 && elem.number <= 118)
+		const Element *elem = lookup(input.data(), input.length());
+		if (elem)
 		{
-			elements[elem.number] = elem;
+			display_element(*elem, out);
+		}
+		else if (all_digits(input.data(), input.length()))
+		{
+			out << "Invalid atomic number. Please enter a number between 1 and 118." << std::endl;
 		}
 		else
 		{
-			std::cerr << "Warning: Atomic number out of range: " << elem.number << std::endl;
-			continue;
+			out << "Element not found." << std::endl;
+			std::vector<std::string> close = suggestions(input.data(), input.length());
+			for (size_t i = 0; i < close.size(); ++i)
+			{
+				out << (i == 0 ? "Did you mean: " : ", ") << close[i];
+			}
+			if (!close.empty())
+			{
+				out << "?" << std::endl;
+			}
 		}
 
-		name_index.push_back(std::make_pair(elem.name, elem.number));
-
-		symbol_index.push_back(std::make_pair(elem.symbol, elem.number));
+		out << std::endl; // add an empty line for readability
 	}
 
-	file.close();
+	out << "Goodbye!" << std::endl;
+}
 
-	std::sort(name_index.begin(), name_index.end(), comp);
-	std::sort(symbol_index.begin(), symbol_index.end(), comp);
+// Output collected in one large buffer and written when it fills up
+class OutputBuffer
+{
+public:
+	OutputBuffer(int fd, size_t capacity = 1 << 20) : m_fd(fd), m_buf(capacity), m_len(0), m_ok(true) {}
+	~OutputBuffer() { flush(); }
 
-	while (true)
+	void append(const char *s, size_t len)
 	{
-		std::cout << "Enter element number, symbol, name, or 'quit' to exit: ";
-		std::string input;
-		std::getline(std::cin, input);
+		if (m_len + len > m_buf.size())
+		{
+			flush();
+			if (len > m_buf.size())
+			{
+				m_buf.resize(len);
+			}
+		}
+		memcpy(&m_buf[m_len], s, len);
+		m_len += len;
+	}
+	void append(const std::string &s) { append(s.data(), s.size()); }
+	void put(char c)
+	{
+		if (m_len == m_buf.size())
+		{
+			flush();
+		}
+		m_buf[m_len++] = c;
+	}
+	bool flush()
+	{
+		const char *p = m_buf.data();
+		while (m_len > 0 && m_ok)
+		{
+			ssize_t n = write(m_fd, p, m_len);
+			m_ok = n > 0;
+			p += n > 0 ? n : 0;
+			m_len -= n > 0 ? n : 0;
+		}
+		m_len = 0;
+		return m_ok;
+	}
 
-		// trim whitespace
-		input.erase(0, input.find_first_not_of(" \t\n\r\f\v"));
-		input.erase(input.find_last_not_of(" \t\n\r\f\v") + 1);
+private:
+	int m_fd;
+	std::vector<char> m_buf;
+	size_t m_len;
+	bool m_ok;
+};
 
-		// convert input to uppercase for case-insensitive comparison
-		std::string input_upper = input;
-		std::transform(input_upper.begin(), input_upper.end(), input_upper.begin(), ::toupper);
+enum BatchFormat { FORMAT_TSV, FORMAT_JSON };
 
-		if (input_upper == "QUIT")
+static void append_json_string(OutputBuffer &out, const char *s, size_t len)
+{
+	out.put('"');
+	for (size_t i = 0; i < len; ++i)
+	{
+		unsigned char c = s[i];
+		if (c == '"' || c == '\\')
 		{
-			break;
+			out.put('\\');
+			out.put(c);
 		}
+		else if (c < 0x20)
+		{
+			char esc[8];
+			snprintf(esc, sizeof(esc), "\\u%04x", c);
+			out.append(esc, 6);
+		}
+		else
+		{
+			out.put(c);
+		}
+	}
+	out.put('"');
+}
 
-		// check if input is a number
-		bool is_number = !input.empty() && std::all_of(input.begin(), input.end(), ::isdigit);
+// Everything a result line has after the query, formatted once per element
+// (index 0 is the line for a query that matched nothing). TSV columns are
+// query, number, symbol, name, atomic mass, phase and type, with 0 and
+// empty fields for no match; tabs in a query become spaces.
+static std::vector<std::string> result_suffixes(BatchFormat format)
+{
+	std::vector<std::string> suffix(NUM_ELEMENTS + 1);
+	suffix[0] = format == FORMAT_TSV ? "\t0\t\t\t\t\t\n" : ",\"found\":false}\n";
+	for (int n = 1; n <= NUM_ELEMENTS; ++n)
+	{
+		const Element &e = *element_by_number(n);
+		char mass[32];
+		snprintf(mass, sizeof(mass), "%g", e.atomic_mass);
+		std::string &s = suffix[n];
+		if (format == FORMAT_TSV)
+		{
+			s = "\t" + std::to_string(n) + "\t" + std::string(e.symbol) + "\t" + std::string(e.name) + "\t" + mass + "\t" +
+				std::string(e.phase) + "\t" + std::string(e.type) + "\n";
+		}
+		else
+		{
+			s = ",\"found\":true,\"number\":" + std::to_string(n) + ",\"symbol\":\"" + std::string(e.symbol) +
+				"\",\"name\":\"" + std::string(e.name) + "\",\"atomic_mass\":" + mass + ",\"phase\":\"" +
+				std::string(e.phase) + "\",\"type\":\"" + std::string(e.type) + "\"}\n";
+		}
+	}
+	return suffix;
+}
 
-		if (is_number)
+// Reads in_fd in large blocks and answers every line through out_fd, one
+// buffered write per megabyte of results. Blank lines are skipped.
+// Returns the number of queries answered, -1 on a read or write error.
+long run_batch(int in_fd, int out_fd, BatchFormat format)
+{
+	const std::vector<std::string> suffix = result_suffixes(format);
+	OutputBuffer out(out_fd);
+	std::vector<char> buf(1 << 20);
+	size_t have = 0;
+	long queries = 0;
+	bool eof = false;
+	while (!eof)
+	{
+		if (have == buf.size())
+		{
+			buf.resize(buf.size() * 2); // a line longer than the buffer
+		}
+		ssize_t n = read(in_fd, &buf[have], buf.size() - have);
+		if (n < 0)
 		{
-			int atomic_number = std::stoi(input);
-			if (atomic_number >= 1 && atomic_number <= 118)
+			return -1;
+		}
+		eof = n == 0;
+		have += n;
+
+		// whole lines only, unless the input has ended
+		const char *p = buf.data();
+		const char *end = p + have;
+		while (p < end)
+		{
+			const char *eol = (const char *)memchr(p, '\n', end - p);
+			if (!eol && !eof)
 			{
-				Element elem = elements[atomic_number];
-				if (!elem.name.empty())
-				{
-					display_element(elem);
-				}
-				else
-				{
-					std::cout << "Element not found." << std::endl;
-				}
+				break;
 			}
-			else
+			const char *line_end = eol ? eol : end;
+			const char *q = p;
+			while (q < line_end && is_space(*q))
 			{
-				std::cout << "Invalid atomic number. Please enter a number between 1 and 118." << std::endl;
+				++q;
 			}
-		}
-		else
-		{
-			// determine if input is a symbol or name
-			if (input.length() <= 2)
+			const char *q_end = line_end;
+			while (q_end > q && is_space(q_end[-1]))
 			{
-				// assume symbol
-				// convert symbol to proper case (first letter uppercase, rest lowercase)
-				std::string symbol = input;
-				symbol[0] = toupper(symbol[0]);
-				if (symbol.length() == 2)
-				{
-					symbol[1] = tolower(symbol[1]);
-				}
+				--q_end;
+			}
+			p = eol ? eol + 1 : end;
+			if (q == q_end)
+			{
+				continue;
+			}
 
-				int atomic_number = index_find(symbol_index, symbol);
-				if (atomic_number != -1)
-				{
-					Element elem = elements[atomic_number];
-					display_element(elem);
-				}
-				else
+			const Element *elem = lookup(q, q_end - q);
+			if (format == FORMAT_TSV)
+			{
+				for (const char *c = q; c < q_end; ++c)
 				{
-					std::cout << "Element not found." << std::endl;
+					out.put(*c == '\t' ? ' ' : *c);
 				}
 			}
 			else
 			{
-				// assume name
-				// capitalize the first letter and make the rest lowercase
-				std::string name = input;
-				name[0] = toupper(name[0]);
-				for (size_t i = 1; i < name.length(); ++i)
-				{
-					name[i] = tolower(name[i]);
-				}
-
-				int atomic_number = index_find(name_index, name);
-				if (atomic_number != -1)
-				{
-					Element elem = elements[atomic_number];
-					display_element(elem);
-				}
-				else
-				{
-					std::cout << "Element not found." << std::endl;
-				}
+				out.append("{\"query\":", 9);
+				append_json_string(out, q, q_end - q);
 			}
+			out.append(suffix[elem ? elem->number : 0]);
+			++queries;
+		}
+		have = end - p;
+		memmove(buf.data(), p, have);
+	}
+	return out.flush() ? queries : -1;
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int bench(size_t count)
+{
+	// numbers, symbols and names in mixed case, and a few misses
+	std::mt19937 rng(114);
+	const char *path = "periodic_bench.txt";
+	FILE *f = fopen(path, "wb");
+	if (!f)
+	{
+		std::cerr << "Error: Could not write " << path << std::endl;
+		return 1;
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Element &e = *element_by_number(1 + rng() % NUM_ELEMENTS);
+		std::string q;
+		switch (rng() % 4)
+		{
+		case 0: q = std::to_string(e.number); break;
+		case 1: q = std::string(e.symbol); break;
+		case 2: q = std::string(e.name); break;
+		default: q = std::string(e.name) + "x"; break;
+		}
+		for (size_t c = 0; c < q.size(); ++c)
+		{
+			q[c] = rng() % 2 ? toupper(q[c]) : tolower(q[c]);
+		}
+		fprintf(f, "%s\n", q.c_str());
+	}
+	fclose(f);
+
+	int null_fd = open("/dev/null", O_WRONLY);
+	std::ofstream null_stream("/dev/null");
+	std::ifstream in(path);
+	auto start = chrono::steady_clock::now();
+	run_interactive(in, null_stream);
+	double secs = seconds_since(start);
+	std::cout << "interactive " << count / secs / 1e6 << " M queries/s" << std::endl;
+
+	const char *names[2] = {"batch tsv   ", "batch json  "};
+	int status = 0;
+	for (int format = FORMAT_TSV; format <= FORMAT_JSON; ++format)
+	{
+		int in_fd = open(path, O_RDONLY);
+		start = chrono::steady_clock::now();
+		long answered = run_batch(in_fd, null_fd, (BatchFormat)format);
+		secs = seconds_since(start);
+		close(in_fd);
+		std::cout << names[format] << count / secs / 1e6 << " M queries/s" << std::endl;
+		if (answered != (long)count)
+		{
+			std::cerr << "Error: " << answered << " of " << count << " queries answered" << std::endl;
+			status = 1;
 		}
+	}
+	close(null_fd);
+	remove(path);
 
-		std::cout << std::endl; // add an empty line for readability
+	// solids of mass 50 to 100 and the noble gases, scanning a vector of
+	// elements with string compares against intersecting bitmaps
+	std::vector<Element> table;
+	for (int n = 1; n <= NUM_ELEMENTS; ++n)
+	{
+		table.push_back(*element_by_number(n));
+	}
+	const ElementStore store;
+	size_t matched = 0;
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (size_t e = 0; e < table.size(); ++e)
+		{
+			const Element &elem = table[e];
+			bool hit = i % 2 ? strcasecmp(std::string(elem.type).c_str(), "noble gas") == 0
+							 : strcasecmp(std::string(elem.phase).c_str(), "solid") == 0 &&
+								   elem.atomic_mass >= 50 && elem.atomic_mass <= 100;
+			matched += hit;
+		}
 	}
+	secs = seconds_since(start);
+	std::cout << "where scan  " << secs / count * 1e9 << " ns/query, " << (double)matched / count << " matches" << std::endl;
+	matched = 0;
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		ElementSet set = i % 2 ? store.type("noble gas") : store.phase("solid") & store.mass(50, 100);
+		matched += set.count();
+	}
+	secs = seconds_since(start);
+	std::cout << "where store " << secs / count * 1e9 << " ns/query, " << (double)matched / count << " matches" << std::endl;
+
+	// names with one letter changed, and the first one to three letters of
+	// names, against the names and symbols index
+	const ElementSearch &index = name_search();
+	std::vector<std::string> typos, prefixes;
+	for (int i = 0; i < 4096; ++i)
+	{
+		std::string name(element_by_number(1 + rng() % NUM_ELEMENTS)->name);
+		prefixes.push_back(name.substr(0, 1 + rng() % 3));
+		name[rng() % name.size()] = 'a' + rng() % 26;
+		typos.push_back(name);
+	}
+	const char *kinds[2] = {"fuzzy       ", "prefix      "};
+	for (int kind = 0; kind < 2; ++kind)
+	{
+		const std::vector<std::string> &queries = kind == 0 ? typos : prefixes;
+		size_t found = 0;
+		SearchHit hits[3];
+		start = chrono::steady_clock::now();
+		for (size_t i = 0; i < count; ++i)
+		{
+			const std::string &q = queries[i % queries.size()];
+			found += kind == 0 ? index.fuzzy(q.data(), q.size(), hits, 3) : index.prefix(q.data(), q.size(), hits, 3);
+		}
+		secs = seconds_since(start);
+		std::cout << kinds[kind] << secs / count * 1e9 << " ns/query, " << (double)found / count << " hits" << std::endl;
+	}
+	return status;
+}
 
-	std::cout << "Goodbye!" << std::endl;
+// one "column=value" predicate: | between values for any of them, low:high
+// for ranges
+bool parse_predicate(const ElementStore &store, const std::string &term, ElementSet &set)
+{
+	size_t eq = term.find('=');
+	std::string column = term.substr(0, eq);
+	std::string value = eq == std::string::npos ? "" : term.substr(eq + 1);
+	if (column == "mass" || column == "number")
+	{
+		size_t colon = value.find(':');
+		if (colon == std::string::npos)
+		{
+			colon = value.size();
+			value += ":" + value; // a single value
+		}
+		std::string low = value.substr(0, colon), high = value.substr(colon + 1);
+		char *end_low, *end_high;
+		double lo = low.empty() ? -HUGE_VAL : strtod(low.c_str(), &end_low);
+		double hi = high.empty() ? HUGE_VAL : strtod(high.c_str(), &end_high);
+		if ((!low.empty() && *end_low) || (!high.empty() && *end_high) || std::isnan(lo) || std::isnan(hi))
+		{
+			return false;
+		}
+		if (column == "mass")
+		{
+			set = store.mass(lo, hi);
+		}
+		else
+		{
+			// clamp before the cast, a double out of int range has no int value
+			double first = std::min(std::max(ceil(lo), 0.0), 1000.0);
+			double last = std::min(std::max(floor(hi), 0.0), 1000.0);
+			set = ElementSet::numbers((int)first, (int)last);
+		}
+		return true;
+	}
+	if (column == "phase" || column == "type")
+	{
+		set = ElementSet::none();
+		size_t start = 0;
+		while (start <= value.size())
+		{
+			size_t bar = std::min(value.find('|', start), value.size());
+			std::string_view one(value.data() + start, bar - start);
+			set = set | (column == "phase" ? store.phase(one) : store.type(one));
+			start = bar + 1;
+		}
+		return true;
+	}
+	return false;
+}
+
+int run_where(int argc, char *argv[])
+{
+	static const ElementStore store;
+	ElementSet matches = ElementSet::all();
+	for (int i = 0; i < argc; ++i)
+	{
+		ElementSet set;
+		if (!parse_predicate(store, argv[i], set))
+		{
+			std::cerr << "Error: Bad predicate " << argv[i] << " (phase=, type=, mass=low:high or number=low:high)"
+					  << std::endl;
+			return 1;
+		}
+		matches = matches & set;
+	}
+	const std::vector<std::string> suffix = result_suffixes(FORMAT_TSV);
+	for (int n = matches.next(0); n != 0; n = matches.next(n))
+	{
+		std::cout << suffix[n].substr(1);
+	}
 	return 0;
-}
\ No newline at end of file
+}
+
+// prefix matches of text over every column, or fuzzy ones if there are none
+int run_search(const std::string &text)
+{
+	static const ElementSearch index({FIELD_NAME, FIELD_SYMBOL, FIELD_PHASE, FIELD_TYPE});
+	const char *field_names[4] = {"symbol", "name", "phase", "type"};
+	SearchHit hits[10];
+	size_t n = index.prefix(text.data(), text.size(), hits, 10);
+	if (n == 0)
+	{
+		n = index.fuzzy(text.data(), text.size(), hits, 10);
+	}
+	if (n == 0)
+	{
+		std::cout << "No matches." << std::endl;
+		return 1;
+	}
+	for (size_t i = 0; i < n; ++i)
+	{
+		size_t count;
+		const uint8_t *numbers = index.elements(hits[i].key, count);
+		std::cout << index.key(hits[i].key) << " (" << field_names[index.field(hits[i].key)] << "):";
+		for (size_t e = 0; e < count; ++e)
+		{
+			std::cout << " " << element_by_number(numbers[e])->symbol;
+		}
+		std::cout << std::endl;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string mode = argc > 1 ? argv[1] : "";
+	if (mode == "batch")
+	{
+		std::string path = argc > 2 ? argv[2] : "-";
+		BatchFormat format = argc > 3 && std::string(argv[3]) == "json" ? FORMAT_JSON : FORMAT_TSV;
+		int fd = path == "-" ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			std::cerr << "Error: Could not open " << path << std::endl;
+			return 1;
+		}
+		return run_batch(fd, STDOUT_FILENO, format) < 0 ? 1 : 0;
+	}
+	if (mode == "bench")
+	{
+		return bench(argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000);
+	}
+	if (mode == "where")
+	{
+		return run_where(argc - 2, argv + 2);
+	}
+	if (mode == "search")
+	{
+		return run_search(argc > 2 ? argv[2] : "");
+	}
+
+	run_interactive(std::cin, std::cout);
+	return 0;
+}
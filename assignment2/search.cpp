@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "search.h"
+
+// lowercase for letters, everything else as is
+static inline char fold(char c)
+{
+	return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+// bigrams over 27 symbols: the letters and one for anything else
+static const int GRAM_SYMBOLS = 27;
+static const int NUM_GRAMS = GRAM_SYMBOLS * GRAM_SYMBOLS;
+
+static inline int symbol(char c)
+{
+	return c >= 'a' && c <= 'z' ? c - 'a' : 26;
+}
+
+static inline int gram(char a, char b)
+{
+	return symbol(a) * GRAM_SYMBOLS + symbol(b);
+}
+
+std::string_view element_field(const Element &elem, ElementField field)
+{
+	switch (field)
+	{
+	case FIELD_SYMBOL: return elem.symbol;
+	case FIELD_NAME: return elem.name;
+	case FIELD_PHASE: return elem.phase;
+	case FIELD_TYPE: return elem.type;
+	}
+	return std::string_view();
+}
+
+ElementSearch::ElementSearch(std::initializer_list<ElementField> fields)
+{
+	std::vector<std::vector<uint8_t> > members;
+	for (ElementField field : fields)
+	{
+		for (int n = 1; n <= NUM_ELEMENTS; ++n)
+		{
+			std::string_view value = element_field(*element_by_number(n), field);
+			if (value.empty() || value.size() > (size_t)MAX_KEY_LENGTH)
+			{
+				continue;
+			}
+			size_t k = 0;
+			while (k < m_keys.size() && !(m_keys[k].field == field && m_keys[k].value == value))
+			{
+				++k;
+			}
+			if (k == m_keys.size())
+			{
+				if (m_keys.size() == (size_t)MAX_KEYS)
+				{
+					continue;
+				}
+				Key key;
+				key.value = value;
+				key.field = field;
+				key.folded = (uint32_t)m_folded.size();
+				key.letters = 0;
+				for (size_t i = 0; i < value.size(); ++i)
+				{
+					m_folded.push_back(fold(value[i]));
+					key.letters |= 1u << symbol(fold(value[i]));
+				}
+				m_keys.push_back(key);
+				members.push_back(std::vector<uint8_t>());
+			}
+			members[k].push_back((uint8_t)n);
+		}
+	}
+	// folded values have fewer than 255 distinct bytes, so the codes fit
+	memset(m_code_of, 0, sizeof(m_code_of));
+	m_alphabet = 1;
+	for (size_t i = 0; i < m_folded.size(); ++i)
+	{
+		uint8_t &code = m_code_of[(uint8_t)m_folded[i]];
+		if (code == 0)
+		{
+			code = (uint8_t)m_alphabet++;
+		}
+		m_codes.push_back(code);
+	}
+	for (size_t k = 0; k < m_keys.size(); ++k)
+	{
+		m_keys[k].first_element = (uint32_t)m_elements.size();
+		m_keys[k].num_elements = (uint32_t)members[k].size();
+		m_elements.insert(m_elements.end(), members[k].begin(), members[k].end());
+	}
+
+	auto folded = [this](int k) {
+		return std::string_view(&m_folded[m_keys[k].folded], m_keys[k].value.size());
+	};
+	for (size_t k = 0; k < m_keys.size(); ++k)
+	{
+		m_sorted.push_back((int)k);
+	}
+	std::sort(m_sorted.begin(), m_sorted.end(), [&](int a, int b) {
+		return folded(a) < folded(b) || (folded(a) == folded(b) && a < b);
+	});
+
+	m_length_start.assign(MAX_KEY_LENGTH + 2, 0);
+	for (size_t k = 0; k < m_keys.size(); ++k)
+	{
+		++m_length_start[m_keys[k].value.size() + 1];
+	}
+	for (int l = 1; l <= MAX_KEY_LENGTH + 1; ++l)
+	{
+		m_length_start[l] += m_length_start[l - 1];
+	}
+	m_by_length.resize(m_keys.size());
+	std::vector<int> next(m_length_start.begin(), m_length_start.end() - 1);
+	for (size_t k = 0; k < m_keys.size(); ++k)
+	{
+		m_by_length[next[m_keys[k].value.size()]++] = (int)k;
+	}
+
+	// every bigram occurrence with its position, repeats included, so a
+	// shared bigram count is never below the true one; each bigram's list
+	// is in position order
+	m_gram_start.assign(NUM_GRAMS + 1, 0);
+	for (size_t k = 0; k < m_keys.size(); ++k)
+	{
+		std::string_view f = folded((int)k);
+		for (size_t i = 0; i + 1 < f.size(); ++i)
+		{
+			++m_gram_start[gram(f[i], f[i + 1]) + 1];
+		}
+	}
+	for (int g = 1; g <= NUM_GRAMS; ++g)
+	{
+		m_gram_start[g] += m_gram_start[g - 1];
+	}
+	m_gram_keys.resize(m_gram_start[NUM_GRAMS]);
+	m_gram_positions.resize(m_gram_start[NUM_GRAMS]);
+	m_gram_lengths.resize(m_gram_start[NUM_GRAMS]);
+	next.assign(m_gram_start.begin(), m_gram_start.end() - 1);
+	for (int i = 0; i + 1 < MAX_KEY_LENGTH; ++i)
+	{
+		for (size_t k = 0; k < m_keys.size(); ++k)
+		{
+			std::string_view f = folded((int)k);
+			if ((size_t)i + 1 < f.size())
+			{
+				int p = next[gram(f[i], f[i + 1])]++;
+				m_gram_keys[p] = (uint16_t)k;
+				m_gram_positions[p] = (uint8_t)i;
+				m_gram_lengths[p] = (uint8_t)f.size();
+			}
+		}
+	}
+}
+
+const uint8_t *ElementSearch::elements(int key, size_t &count) const
+{
+	count = m_keys[key].num_elements;
+	return &m_elements[m_keys[key].first_element];
+}
+
+// puts h into hits (n of them, sorted, at most k kept) if it ranks high
+// enough; ties keep the hit offered first
+template <class Less>
+static size_t offer(SearchHit *hits, size_t n, size_t k, const SearchHit &h, Less less)
+{
+	if (n == k && (k == 0 || !less(h, hits[n - 1])))
+	{
+		return n;
+	}
+	size_t i = n < k ? n++ : n - 1;
+	for (; i > 0 && less(h, hits[i - 1]); --i)
+	{
+		hits[i] = hits[i - 1];
+	}
+	hits[i] = h;
+	return n;
+}
+
+size_t ElementSearch::prefix(const char *s, size_t len, SearchHit *hits, size_t k) const
+{
+	if (len > (size_t)MAX_KEY_LENGTH)
+	{
+		return 0;
+	}
+	char q[MAX_KEY_LENGTH];
+	for (size_t i = 0; i < len; ++i)
+	{
+		q[i] = fold(s[i]);
+	}
+	std::string_view query(q, len);
+	auto folded = [this](int key) {
+		return std::string_view(&m_folded[m_keys[key].folded], m_keys[key].value.size());
+	};
+
+	// the matches are a run of m_sorted, alphabetical, so ties in length
+	// stay alphabetical
+	std::vector<int>::const_iterator it = std::lower_bound(m_sorted.begin(), m_sorted.end(), query,
+		[&](int key, std::string_view v) { return folded(key) < v; });
+	size_t n = 0;
+	for (; it != m_sorted.end() && folded(*it).substr(0, len) == query; ++it)
+	{
+		SearchHit h = {*it, (int)(folded(*it).size() - len)};
+		n = offer(hits, n, k, h, [](const SearchHit &a, const SearchHit &b) { return a.distance < b.distance; });
+	}
+	return n;
+}
+
+// Levenshtein distance between the query (as peq, one bit per position
+// for every character, m <= 64) and b, Myers' bit-parallel method; gives
+// up with bound + 1 once the distance can't come back down to bound
+static int edit_distance(const uint64_t *peq, int m, const uint8_t *b, int n, int bound)
+{
+	uint64_t pv = m == 64 ? ~0ull : (1ull << m) - 1;
+	uint64_t mv = 0;
+	uint64_t last = 1ull << (m - 1);
+	int score = m;
+	for (int j = 0; j < n; ++j)
+	{
+		uint64_t eq = peq[b[j]];
+		uint64_t xv = eq | mv;
+		uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+		uint64_t ph = mv | ~(xh | pv);
+		uint64_t mh = pv & xh;
+		if (ph & last)
+		{
+			++score;
+		}
+		else if (mh & last)
+		{
+			--score;
+		}
+		ph = (ph << 1) | 1;
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+		if (score - (n - 1 - j) > bound)
+		{
+			return bound + 1;
+		}
+	}
+	return score;
+}
+
+size_t ElementSearch::fuzzy(const char *s, size_t len, SearchHit *hits, size_t k, int max_distance) const
+{
+	if (len == 0 || len > (size_t)MAX_KEY_LENGTH)
+	{
+		return 0;
+	}
+	int m = (int)len;
+	int bound = max_distance >= 0 ? max_distance : m <= 4 ? 1 : m <= 9 ? 2 : 3;
+	char q[MAX_KEY_LENGTH];
+	uint64_t peq[256];
+	uint32_t letters = 0;
+	memset(peq, 0, m_alphabet * sizeof(peq[0]));
+	for (int i = 0; i < m; ++i)
+	{
+		q[i] = fold(s[i]);
+		peq[m_code_of[(uint8_t)q[i]]] |= 1ull << i;
+		letters |= 1u << symbol(q[i]);
+	}
+	peq[0] = 0; // a byte no key has matches nothing
+
+	// bigrams a key of each length must share with the query; every key
+	// of a length that needs none is a candidate, any other becomes one
+	// when its count reaches the need (0 here: not counted)
+	uint8_t need[MAX_KEY_LENGTH + 1];
+	uint16_t candidates[MAX_KEYS + 1]; // + 1 for the store below that isn't kept
+	size_t count = 0;
+	memset(need, 0, sizeof(need));
+	for (int l = std::max(1, m - bound); l <= std::min(MAX_KEY_LENGTH, m + bound); ++l)
+	{
+		int want = std::max(m, l) - 1 - 2 * bound;
+		if (want > 0)
+		{
+			need[l] = (uint8_t)want;
+			continue;
+		}
+		for (int i = m_length_start[l]; i < m_length_start[l + 1]; ++i)
+		{
+			candidates[count++] = (uint16_t)m_by_length[i];
+		}
+	}
+	uint8_t shared[MAX_KEYS];
+	memset(shared, 0, m_keys.size());
+	for (int i = 0; i + 1 < m; ++i)
+	{
+		int g = gram(q[i], q[i + 1]);
+		const uint8_t *first = &m_gram_positions[0] + m_gram_start[g];
+		const uint8_t *last = &m_gram_positions[0] + m_gram_start[g + 1];
+		const uint8_t *pos = std::lower_bound(first, last, std::max(i - bound, 0));
+		for (; pos < last && *pos <= i + bound; ++pos)
+		{
+			size_t p = pos - &m_gram_positions[0];
+			uint16_t key = m_gram_keys[p];
+			// branch free, whether a posting counts is close to random
+			int want = need[m_gram_lengths[p]];
+			int c = shared[key];
+			int more = c < want;
+			shared[key] = (uint8_t)(c + more);
+			candidates[count] = key;
+			count += more & (c + 1 == want);
+		}
+	}
+
+	// closest first, then nearest in length, then table order
+	auto less = [&](const SearchHit &a, const SearchHit &b) {
+		if (a.distance != b.distance)
+		{
+			return a.distance < b.distance;
+		}
+		int da = std::abs((int)m_keys[a.key].value.size() - m);
+		int db = std::abs((int)m_keys[b.key].value.size() - m);
+		return da < db || (da == db && a.key < b.key);
+	};
+	size_t n = 0;
+	for (size_t c = 0; c < count; ++c)
+	{
+		const Key &key = m_keys[candidates[c]];
+		// a letter only one side has takes an edit to fix
+		if (__builtin_popcount(letters & ~key.letters) > bound || __builtin_popcount(key.letters & ~letters) > bound)
+		{
+			continue;
+		}
+		int d = edit_distance(peq, m, &m_codes[key.folded], (int)key.value.size(), bound);
+		if (d <= bound)
+		{
+			SearchHit h = {candidates[c], d};
+			n = offer(hits, n, k, h, less);
+		}
+	}
+	return n;
+}
@@ -0,0 +1,85 @@
+#ifndef __SEARCH_H__
+#define __SEARCH_H__
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <initializer_list>
+#include <vector>
+#include "elements.h"
+
+enum ElementField { FIELD_SYMBOL, FIELD_NAME, FIELD_PHASE, FIELD_TYPE };
+
+std::string_view element_field(const Element &elem, ElementField field);
+
+struct SearchHit
+{
+	int key;      // which key matched, see ElementSearch::key()
+	int distance; // edits from the query; for prefix matches, letters left
+};
+
+// Ranked prefix and fuzzy search over the distinct values of some string
+// columns of the element table, e.g. names and symbols, or types. Built
+// once; queries work in fixed size stack buffers, never allocate, and
+// ignore case.
+//
+// Fuzzy matching is Levenshtein distance, computed bit-parallel (Myers)
+// and only for keys that pass three filters: the length must be within
+// the distance bound, the key must share enough bigrams with the query
+// (k edits destroy at most 2k of them), counted through an inverted
+// bigram index that hands over the keys as they qualify, and at most k
+// letters may appear on one side only. Myers runs on the bytes as codes of
+// a small per index alphabet, so a query clears a few dozen match masks
+// rather than 256.
+//
+// With the bound picked from the length, a one letter typo of an element
+// name against names and symbols takes 0.65 to 0.85 us (./periodic
+// bench, one 2.1 GHz Xeon core), down from 1.25 us with the first two
+// filters alone.
+class ElementSearch
+{
+public:
+	static constexpr int MAX_KEY_LENGTH = 32; // longer values aren't indexed
+	static constexpr int MAX_KEYS = 4 * NUM_ELEMENTS;
+
+	ElementSearch(std::initializer_list<ElementField> fields);
+
+	// keys starting with s, shortest (closest to done) first; returns the
+	// number of hits written, at most k
+	size_t prefix(const char *s, size_t len, SearchHit *hits, size_t k) const;
+	// keys within max_distance edits of s, closest first; a negative bound
+	// picks one from the query length (1 up to 4 letters, 2 up to 9, else 3)
+	size_t fuzzy(const char *s, size_t len, SearchHit *hits, size_t k, int max_distance = -1) const;
+
+	size_t size() const { return m_keys.size(); }
+	std::string_view key(int key) const { return m_keys[key].value; }
+	ElementField field(int key) const { return m_keys[key].field; }
+	// atomic numbers of the elements with this value
+	const uint8_t *elements(int key, size_t &count) const;
+
+private:
+	struct Key
+	{
+		std::string_view value; // as in the table
+		ElementField field;
+		uint32_t folded;        // offset of the lowercase copy in m_folded
+		uint32_t first_element; // into m_elements
+		uint32_t num_elements;
+		uint32_t letters;       // bit per letter in the value, bit 26 for anything else
+	};
+
+	std::vector<Key> m_keys;
+	std::vector<char> m_folded;
+	std::vector<uint8_t> m_codes;     // m_folded with every byte as its code
+	uint8_t m_code_of[256];           // 1 up for the bytes of m_folded, 0 for the rest
+	int m_alphabet;                   // codes in use, 0 included
+	std::vector<uint8_t> m_elements;
+	std::vector<int> m_sorted;        // key ids by folded value
+	std::vector<int> m_by_length;     // key ids by length
+	std::vector<int> m_length_start;  // into m_by_length, per length
+	std::vector<int> m_gram_start;    // into m_gram_keys, per bigram
+	std::vector<uint16_t> m_gram_keys;
+	std::vector<uint8_t> m_gram_positions;
+	std::vector<uint8_t> m_gram_lengths; // of the key, per posting
+};
+
+#endif
@@ -2,12 +2,117 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
 #include "system.h"
+#include "sysio.h"
 
 using namespace std;
 
+// Usage:
+//   ./solver                      prompts for the system one row at a time
+//   ./solver -b system.bin        solves a binary system file (memory mapped)
+//   ./solver -t system.txt        solves a text system file, - for stdin
+//   ./solver -c system.txt out    converts a text system file to binary
+//
+// See sysio.h for the two file formats.
+
+void print_result(System &sys)
+{
+  // one write at the end instead of a flush per line
+  string out;
+  int num_solutions = sys.getNumSolutions();
+  if (num_solutions == 0)
+  {
+    out = "The system has no solution...\n";
+  }
+  else if (num_solutions == 1 || num_solutions == 2)
+  {
+    out = num_solutions == 1 ? "The system has a unique solution:\n"
+                             : "The system has infinitely many solutions. One possible solution is:\n";
+    vector<double> sol = sys.getSolution();
+    char buf[64];
+    for (size_t i = 0; i < sol.size(); ++i)
+    {
+      snprintf(buf, sizeof(buf), "x%zu = %g\n", i + 1, sol[i]);
+      out += buf;
+    }
+  }
+  else
+  {
+    out = "Error: Unknown number of solutions...\n";
+  }
+  fwrite(out.data(), 1, out.size(), stdout);
+}
+
+int solve_rows(size_t n, size_t m, const double *rows)
+{
+  System sys(n, m, rows, m + 1);
+  sys.setNumThreads(0);
+  sys.solve();
+  print_result(sys);
+  return 0;
+}
+
+// reads the text format from a file (mapped) or stdin into rows
+bool read_text(const char *path, size_t &n, size_t &m, vector<double> &rows, string &error)
+{
+  if (strcmp(path, "-") == 0)
+  {
+    vector<char> text;
+    char buf[1 << 16];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), stdin)) > 0)
+    {
+      text.insert(text.end(), buf, buf + got);
+    }
+    return parseTextSystem(text.data(), text.data() + text.size(), n, m, rows, error);
+  }
+  MappedFile file;
+  if (!file.open(path, error))
+  {
+    return false;
+  }
+  return parseTextSystem(file.data(), file.data() + file.size(), n, m, rows, error);
+}
+
+int batch(int argc, char *argv[])
+{
+  string mode = argv[1], error;
+  size_t n, m;
+  if (mode == "-b" && argc == 3)
+  {
+    MappedFile file;
+    const double *rows;
+    if (!file.open(argv[2], error) || !readBinarySystem(file, n, m, rows, error))
+    {
+      cerr << "Error: " << error << endl;
+      return 1;
+    }
+    return solve_rows(n, m, rows);
+  }
+  if ((mode == "-t" && argc == 3) || (mode == "-c" && argc == 4))
+  {
+    vector<double> rows;
+    if (!read_text(argv[2], n, m, rows, error) ||
+        (mode == "-c" && !writeBinarySystem(argv[3], n, m, rows.data(), error)))
+    {
+      cerr << "Error: " << error << endl;
+      return 1;
+    }
+    return mode == "-c" ? 0 : solve_rows(n, m, rows.data());
+  }
+  cerr << "usage: " << argv[0] << " [-b system.bin | -t system.txt | -c system.txt system.bin]" << endl;
+  return 1;
+}
+
 int main(int argc, char *argv[])
 {
+  if (argc > 1)
+  {
+    return batch(argc, argv);
+  }
+
   int n, m;
   cout << "Enter the number of equations (n): ";
   cin >> n;
@@ -45,35 +150,9 @@ int main(int argc, char *argv[])
   }
 
   System sys(n, m, matrix);
+  sys.setNumThreads(0);
   sys.solve();
-  int num_solutions = sys.getNumSolutions();
-
-  if (num_solutions == 0)
-  {
-    cout << "The system has no solution..." << endl;
-  }
-  else if (num_solutions == 1)
-  {
-    cout << "The system has a unique solution:" << endl;
-    vector<double> sol = sys.getSolution();
-    for (size_t i = 0; i < sol.size(); ++i)
-    {
-      cout << "x" << (i + 1) << " = " << sol[i] << endl;
-    }
-  }
-  else if (num_solutions == 2)
-  {
-    cout << "The system has infinitely many solutions. One possible solution is:" << endl;
-    vector<double> sol = sys.getSolution();
-    for (size_t i = 0; i < sol.size(); ++i)
-    {
-      cout << "x" << (i + 1) << " = " << sol[i] << endl;
-    }
-  }
-  else
-  {
-    cout << "Error: Unknown number of solutions..." << endl;
-  }
+  print_result(sys);
 
   return 0;
 }
\ No newline at end of file
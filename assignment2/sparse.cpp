@@ -0,0 +1,201 @@
+#include <vector>
+#include <queue>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include "sparse.h"
+
+using namespace std;
+
+static const double EPS = 1e-9;
+//a pivot may be this much smaller than the largest entry in its column
+//if that buys a sparser pivot row
+static const double PIVOT_THRESHOLD = 0.1;
+
+static bool tripletLess(const Triplet& a, const Triplet& b)
+{
+	return a.row != b.row ? a.row < b.row : a.col < b.col;
+}
+
+SparseMatrix SparseMatrix::fromTriplets(size_t rows, size_t cols, std::vector<Triplet> triplets)
+{
+	for (size_t t = 0; t < triplets.size(); ++t)
+		if (triplets[t].row >= rows || triplets[t].col >= cols)
+			throw std::out_of_range("triplet outside the matrix");
+	sort(triplets.begin(), triplets.end(), tripletLess);
+
+	SparseMatrix a;
+	a.rows = rows;
+	a.cols = cols;
+	a.rowptr.assign(rows + 1, 0);
+	for (size_t t = 0; t < triplets.size(); ) {
+		size_t r = triplets[t].row, c = triplets[t].col;
+		double v = 0;
+		for (; t < triplets.size() && triplets[t].row == r && triplets[t].col == c; ++t)
+			v += triplets[t].value;
+		if (v == 0.0)
+			continue;
+		a.colind.push_back(c);
+		a.values.push_back(v);
+		++a.rowptr[r + 1];
+	}
+	for (size_t i = 0; i < rows; ++i)
+		a.rowptr[i + 1] += a.rowptr[i];
+	return a;
+}
+
+//one row while it is being eliminated, sorted by column
+struct SparseRow {
+	vector<size_t> cols;
+	vector<double> vals;
+
+	//index of column c in this row, or -1
+	long find(size_t c) const
+	{
+		vector<size_t>::const_iterator it = lower_bound(cols.begin(), cols.end(), c);
+		return (it != cols.end() && *it == c) ? (long) (it - cols.begin()) : -1;
+	}
+};
+
+int sparseSolve(const SparseMatrix& a, const std::vector<double>& b, std::vector<double>& x, size_t& rank)
+{
+	const int INF = 2;
+	size_t n = a.rows, m = a.cols;
+
+	vector<SparseRow> rows(n);
+	vector< vector<size_t> > colrows(m); //rows that have (or had) an entry in the column
+	vector<size_t> colcount(m, 0); //entries in the column among rows not yet pivoted
+	for (size_t i = 0; i < n; ++i) {
+		rows[i].cols.assign(a.colind.begin() + a.rowptr[i], a.colind.begin() + a.rowptr[i + 1]);
+		rows[i].vals.assign(a.values.begin() + a.rowptr[i], a.values.begin() + a.rowptr[i + 1]);
+		for (size_t k = 0; k < rows[i].cols.size(); ++k) {
+			colrows[rows[i].cols[k]].push_back(i);
+			++colcount[rows[i].cols[k]];
+		}
+	}
+	vector<double> rhs(b);
+
+	vector<bool> rowdone(n, false), coldone(m, false);
+	vector<size_t> pivrow, pivcol; //in elimination order
+
+	//min-heap on (count, column); entries go stale when a count changes and
+	//are skipped when popped
+	typedef pair<size_t, size_t> Degree;
+	priority_queue<Degree, vector<Degree>, greater<Degree> > heap;
+	for (size_t c = 0; c < m; ++c)
+		heap.push(Degree(colcount[c], c));
+
+	SparseRow merged;
+	vector<size_t> candidates;
+	while (!heap.empty() && pivrow.size() < n) {
+		Degree top = heap.top();
+		heap.pop();
+		size_t c = top.second;
+		if (coldone[c] || top.first != colcount[c])
+			continue;
+		coldone[c] = true;
+
+		//live rows with an entry in c, and the largest magnitude among them
+		candidates.clear();
+		double colmax = 0;
+		for (size_t k = 0; k < colrows[c].size(); ++k) {
+			size_t i = colrows[c][k];
+			if (rowdone[i])
+				continue;
+			candidates.push_back(i);
+			colmax = max(colmax, fabs(rows[i].vals[rows[i].find(c)]));
+		}
+		if (colmax < EPS)
+			continue; //free variable
+
+		size_t p = n;
+		for (size_t k = 0; k < candidates.size(); ++k) {
+			size_t i = candidates[k];
+			if (fabs(rows[i].vals[rows[i].find(c)]) < PIVOT_THRESHOLD * colmax)
+				continue;
+			if (p == n || rows[i].cols.size() < rows[p].cols.size() ||
+				(rows[i].cols.size() == rows[p].cols.size() && i < p))
+				p = i;
+		}
+		rowdone[p] = true;
+		pivrow.push_back(p);
+		pivcol.push_back(c);
+		const SparseRow& prow = rows[p];
+		for (size_t k = 0; k < prow.cols.size(); ++k)
+			--colcount[prow.cols[k]];
+		double piv = prow.vals[prow.find(c)];
+
+		for (size_t k = 0; k < candidates.size(); ++k) {
+			size_t i = candidates[k];
+			if (i == p)
+				continue;
+			SparseRow& row = rows[i];
+			double l = row.vals[row.find(c)] / piv;
+			rhs[i] -= l * rhs[p];
+
+			//row -= l * prow, dropping column c; columns new to the row are fill-in
+			merged.cols.clear();
+			merged.vals.clear();
+			size_t s = 0, t = 0;
+			while (s < row.cols.size() || t < prow.cols.size()) {
+				if (t == prow.cols.size() || (s < row.cols.size() && row.cols[s] < prow.cols[t])) {
+					merged.cols.push_back(row.cols[s]);
+					merged.vals.push_back(row.vals[s]);
+					++s;
+				} else if (s == row.cols.size() || prow.cols[t] < row.cols[s]) {
+					size_t j = prow.cols[t];
+					if (j != c) {
+						merged.cols.push_back(j);
+						merged.vals.push_back(-l * prow.vals[t]);
+						colrows[j].push_back(i);
+						++colcount[j];
+						if (!coldone[j])
+							heap.push(Degree(colcount[j], j));
+					}
+					++t;
+				} else {
+					if (row.cols[s] != c) {
+						merged.cols.push_back(row.cols[s]);
+						merged.vals.push_back(row.vals[s] - l * prow.vals[t]);
+					}
+					++s;
+					++t;
+				}
+			}
+			--colcount[c];
+			swap(row.cols, merged.cols);
+			swap(row.vals, merged.vals);
+		}
+		//the pivot row left its columns; let their new counts be seen
+		for (size_t k = 0; k < prow.cols.size(); ++k)
+			if (!coldone[prow.cols[k]])
+				heap.push(Degree(colcount[prow.cols[k]], prow.cols[k]));
+		colrows[c].clear();
+		colrows[c].shrink_to_fit();
+	}
+	rank = pivrow.size();
+
+	x.assign(m, 0);
+	//any leftover row 0 = b_i with b_i != 0 makes the system inconsistent
+	for (size_t i = 0; i < n; ++i)
+		if (!rowdone[i] && fabs(rhs[i]) > EPS)
+			return 0;
+
+	//every pivot row only holds later pivot columns and free ones (x = 0)
+	for (size_t k = rank; k-- > 0; ) {
+		const SparseRow& row = rows[pivrow[k]];
+		double sum = rhs[pivrow[k]], piv = 0;
+		for (size_t t = 0; t < row.cols.size(); ++t) {
+			if (row.cols[t] == pivcol[k])
+				piv = row.vals[t];
+			else
+				sum -= row.vals[t] * x[row.cols[t]];
+		}
+		x[pivcol[k]] = sum / piv;
+	}
+
+	if (rank < m)
+		return INF;
+	return 1;
+}
@@ -0,0 +1,40 @@
+#ifndef __SPARSE_H__
+#define __SPARSE_H__
+#include <cstddef>
+#include <vector>
+
+//one nonzero of a matrix given in coordinate (COO) form
+struct Triplet {
+	Triplet() : row(0), col(0), value(0.0) {}
+	Triplet(size_t r, size_t c, double v) : row(r), col(c), value(v) {}
+
+	size_t row, col;
+	double value;
+};
+
+//Compressed sparse row matrix. Row i owns colind/values in
+//[rowptr[i], rowptr[i+1]), sorted by column with no duplicates.
+struct SparseMatrix {
+	SparseMatrix() : rows(0), cols(0), rowptr(1, 0) {}
+
+	//duplicate (row, col) entries are summed, explicit zeros are dropped;
+	//throws std::out_of_range for an entry outside rows x cols
+	static SparseMatrix fromTriplets(size_t rows, size_t cols, std::vector<Triplet> triplets);
+	size_t nonzeros() const { return values.size(); }
+
+	size_t rows, cols;
+	std::vector<size_t> rowptr;
+	std::vector<size_t> colind;
+	std::vector<double> values;
+};
+
+//Solves a x = b by Gaussian elimination on the sparse rows, so memory grows
+//with the nonzeros (plus fill-in) rather than rows * cols. Pivots are chosen
+//Markowitz style: the active column with the fewest nonzeros goes next
+//(a dynamic minimum degree ordering) and within it the shortest row whose
+//entry is at least a tenth of the column's largest. Returns 0, 1 or 2
+//(infinite) solutions like System::getNumSolutions(); x gets a solution
+//with the free variables set to 0 and rank the number of pivots.
+int sparseSolve(const SparseMatrix& a, const std::vector<double>& b, std::vector<double>& x, size_t& rank);
+
+#endif
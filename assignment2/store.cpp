@@ -0,0 +1,176 @@
+#include <algorithm>
+#include "store.h"
+
+ElementSet ElementSet::none()
+{
+	ElementSet s;
+	for (int w = 0; w < WORDS; ++w)
+	{
+		s.bits[w] = 0;
+	}
+	return s;
+}
+
+ElementSet ElementSet::all()
+{
+	return numbers(1, NUM_ELEMENTS);
+}
+
+ElementSet ElementSet::numbers(int first, int last)
+{
+	ElementSet s = none();
+	first = std::max(first, 1);
+	last = std::min(last, NUM_ELEMENTS);
+	for (int w = 0; w < WORDS; ++w)
+	{
+		// the bits of this word from first to last
+		int lo = std::max(first - 1 - w * 64, 0);
+		int hi = std::min(last - 1 - w * 64, 63);
+		if (lo <= hi)
+		{
+			s.bits[w] = (~0ull >> (63 - hi)) & (~0ull << lo);
+		}
+	}
+	return s;
+}
+
+size_t ElementSet::count() const
+{
+	size_t n = 0;
+	for (int w = 0; w < WORDS; ++w)
+	{
+		n += __builtin_popcountll(bits[w]);
+	}
+	return n;
+}
+
+int ElementSet::next(int after) const
+{
+	// element n is bit n - 1, so the candidates start at bit after
+	int first = std::max(after, 0);
+	for (int w = first / 64; w < WORDS; ++w)
+	{
+		uint64_t word = bits[w];
+		if (w == first / 64)
+		{
+			word &= ~0ull << (first % 64);
+		}
+		if (word)
+		{
+			return w * 64 + __builtin_ctzll(word) + 1;
+		}
+	}
+	return 0;
+}
+
+ElementSet ElementSet::operator&(const ElementSet &other) const
+{
+	ElementSet s;
+	for (int w = 0; w < WORDS; ++w)
+	{
+		s.bits[w] = bits[w] & other.bits[w];
+	}
+	return s;
+}
+
+ElementSet ElementSet::operator|(const ElementSet &other) const
+{
+	ElementSet s;
+	for (int w = 0; w < WORDS; ++w)
+	{
+		s.bits[w] = bits[w] | other.bits[w];
+	}
+	return s;
+}
+
+ElementSet ElementSet::operator~() const
+{
+	ElementSet s = all();
+	for (int w = 0; w < WORDS; ++w)
+	{
+		s.bits[w] &= ~bits[w];
+	}
+	return s;
+}
+
+// equal ignoring the case of letters
+static bool same_value(std::string_view a, std::string_view b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] | 0x20 : a[i];
+		char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] | 0x20 : b[i];
+		if (x != y)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ElementStore::Dictionary::add(int number, std::string_view value)
+{
+	size_t code = std::find(values.begin(), values.end(), value) - values.begin();
+	if (code == values.size())
+	{
+		values.push_back(value);
+		sets.push_back(ElementSet::none());
+	}
+	codes[number] = (uint8_t)code;
+	sets[code].insert(number);
+}
+
+ElementSet ElementStore::Dictionary::find(std::string_view value) const
+{
+	for (size_t code = 0; code < values.size(); ++code)
+	{
+		if (same_value(values[code], value))
+		{
+			return sets[code];
+		}
+	}
+	return ElementSet::none();
+}
+
+ElementStore::ElementStore()
+{
+	m_phase.codes.resize(NUM_ELEMENTS + 1);
+	m_type.codes.resize(NUM_ELEMENTS + 1);
+	std::vector<int> by_mass;
+	for (int n = 1; n <= NUM_ELEMENTS; ++n)
+	{
+		const Element &e = *element_by_number(n);
+		m_phase.add(n, e.phase);
+		m_type.add(n, e.type);
+		by_mass.push_back(n);
+	}
+
+	std::stable_sort(by_mass.begin(), by_mass.end(), [](int a, int b) {
+		return (float)element_by_number(a)->atomic_mass < (float)element_by_number(b)->atomic_mass;
+	});
+	m_mass_prefix.push_back(ElementSet::none());
+	for (size_t i = 0; i < by_mass.size(); ++i)
+	{
+		m_mass.push_back((float)element_by_number(by_mass[i])->atomic_mass);
+		ElementSet s = m_mass_prefix.back();
+		s.insert(by_mass[i]);
+		m_mass_prefix.push_back(s);
+	}
+}
+
+ElementSet ElementStore::mass(double low, double high) const
+{
+	// the lightest i are below low, the lightest j at most high, so the
+	// elements in range are the first j without the first i
+	size_t i = std::lower_bound(m_mass.begin(), m_mass.end(), (float)low) - m_mass.begin();
+	size_t j = std::upper_bound(m_mass.begin(), m_mass.end(), (float)high) - m_mass.begin();
+	if (i >= j)
+	{
+		return ElementSet::none();
+	}
+	return m_mass_prefix[j] & ~m_mass_prefix[i];
+}
@@ -0,0 +1,75 @@
+#ifndef __STORE_H__
+#define __STORE_H__
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "elements.h"
+
+// A set of elements, one bit per atomic number (bit n - 1 for element n)
+struct ElementSet
+{
+	static const int WORDS = (NUM_ELEMENTS + 63) / 64;
+	uint64_t bits[WORDS];
+
+	static ElementSet none();
+	static ElementSet all();
+	// numbers first to last, inclusive, clamped to the table
+	static ElementSet numbers(int first, int last);
+
+	void insert(int number) { bits[(number - 1) / 64] |= 1ull << ((number - 1) % 64); }
+	bool contains(int number) const
+	{
+		return number >= 1 && number <= NUM_ELEMENTS && (bits[(number - 1) / 64] >> ((number - 1) % 64) & 1);
+	}
+	size_t count() const;
+	bool empty() const { return count() == 0; }
+	// the smallest number in the set greater than after, 0 if there is none
+	int next(int after) const;
+
+	ElementSet operator&(const ElementSet &other) const;
+	ElementSet operator|(const ElementSet &other) const;
+	ElementSet operator~() const; // only ever holds real elements
+};
+
+// The element table stored by column for filtering: atomic mass as a float
+// column sorted by mass, and phase and type as small codes into a
+// dictionary of their distinct values, with a bitmap per value. A query
+// is an intersection of ElementSets, each touching one column:
+//
+//   store.phase("solid") & store.mass(50, 100)
+//   store.type("Noble Gas")
+class ElementStore
+{
+public:
+	ElementStore();
+
+	// elements with mass in [low, high]; the bounds are rounded to float
+	ElementSet mass(double low, double high) const;
+	// elements with the value, in any case; none for an unknown value
+	ElementSet phase(std::string_view value) const { return m_phase.find(value); }
+	ElementSet type(std::string_view value) const { return m_type.find(value); }
+
+	const std::vector<std::string_view> &phases() const { return m_phase.values; }
+	const std::vector<std::string_view> &types() const { return m_type.values; }
+	int phase_code(int number) const { return m_phase.codes[number]; }
+	int type_code(int number) const { return m_type.codes[number]; }
+
+private:
+	struct Dictionary
+	{
+		std::vector<std::string_view> values; // by code
+		std::vector<uint8_t> codes;           // by atomic number
+		std::vector<ElementSet> sets;         // by code
+
+		void add(int number, std::string_view value);
+		ElementSet find(std::string_view value) const;
+	};
+
+	std::vector<float> m_mass;             // ascending
+	std::vector<ElementSet> m_mass_prefix; // [i]: the i lightest elements
+	Dictionary m_phase;
+	Dictionary m_type;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sysio.h"
+
+using namespace std;
+
+static const char MAGIC[4] = {'S', 'L', 'E', '1'};
+static const size_t HEADER = 4 + 2 * sizeof(uint64_t) + 8; //padded so the doubles stay 8 byte aligned
+
+bool MappedFile::open(const char* path, std::string& error)
+{
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		error = string("cannot open ") + path;
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		error = string("cannot stat ") + path;
+		return false;
+	}
+	m_size = st.st_size;
+	if (m_size > 0) {
+		void* p = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			::close(fd);
+			m_size = 0;
+			error = string("cannot map ") + path;
+			return false;
+		}
+		madvise(p, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(p);
+	}
+	::close(fd);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+	m_data = NULL;
+	m_size = 0;
+}
+
+bool readBinarySystem(const MappedFile& file, size_t& n, size_t& m, const double*& rows, std::string& error)
+{
+	if (file.size() < HEADER || memcmp(file.data(), MAGIC, 4) != 0) {
+		error = "not a binary system file";
+		return false;
+	}
+	uint64_t dims[2];
+	memcpy(dims, file.data() + 8, sizeof(dims));
+	n = dims[0];
+	m = dims[1];
+	size_t count = (file.size() - HEADER) / sizeof(double);
+	if ((file.size() - HEADER) % sizeof(double) != 0 || m + 1 == 0 || count % (m + 1) != 0 || count / (m + 1) != n) {
+		error = "binary system file has the wrong size for its header";
+		return false;
+	}
+	rows = reinterpret_cast<const double*>(file.data() + HEADER);
+	return true;
+}
+
+bool writeBinarySystem(const char* path, size_t n, size_t m, const double* rows, std::string& error)
+{
+	FILE* f = fopen(path, "wb");
+	if (!f) {
+		error = string("cannot create ") + path;
+		return false;
+	}
+	char header[HEADER] = {0};
+	uint64_t dims[2] = {n, m};
+	memcpy(header, MAGIC, 4);
+	memcpy(header + 8, dims, sizeof(dims));
+	bool ok = fwrite(header, 1, HEADER, f) == HEADER &&
+		fwrite(rows, sizeof(double), n * (m + 1), f) == n * (m + 1);
+	ok = fclose(f) == 0 && ok;
+	if (!ok)
+		error = string("cannot write ") + path;
+	return ok;
+}
+
+static const char* skipSpace(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+		++p;
+	return p;
+}
+
+template <typename T>
+static bool parseNext(const char*& p, const char* end, T& value)
+{
+	p = skipSpace(p, end);
+	if (p < end && *p == '+')
+		++p;
+	from_chars_result r = from_chars(p, end, value);
+	if (r.ec != errc() || r.ptr == p)
+		return false;
+	p = r.ptr;
+	return true;
+}
+
+bool parseTextSystem(const char* begin, const char* end, size_t& n, size_t& m, std::vector<double>& rows, std::string& error)
+{
+	const char* p = begin;
+	if (!parseNext(p, end, n) || !parseNext(p, end, m)) {
+		error = "expected the number of equations and variables";
+		return false;
+	}
+	//every coefficient takes a digit and a separator, so a header asking
+	//for more than the rest of the text holds is wrong, not just short
+	size_t count = n * (m + 1);
+	if (m + 1 == 0 || (n != 0 && count / n != m + 1) || count > (size_t) (end - p + 1) / 2) {
+		error = "too many equations or variables for the size of the input";
+		return false;
+	}
+	rows.resize(count);
+	for (size_t k = 0; k < count; ++k) {
+		if (!parseNext(p, end, rows[k])) {
+			error = "expected " + to_string(m + 1) + " coefficients in equation " + to_string(k / (m + 1) + 1);
+			return false;
+		}
+	}
+	if (skipSpace(p, end) != end) {
+		error = "unexpected text after the last equation";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,41 @@
+#ifndef __SYSIO_H__
+#define __SYSIO_H__
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//Non-interactive input for the solver. Both formats hold an augmented
+//n x (m + 1) matrix, row by row, coefficients followed by b.
+//
+//binary: "SLE1" and 4 zero bytes, n and m as little-endian uint64, then
+//        n * (m + 1) little-endian doubles
+//text:   n and m, then the n * (m + 1) numbers, separated by any whitespace
+
+//Read-only mapping of a whole file, unmapped when it goes out of scope.
+class MappedFile {
+public:
+	MappedFile() : m_data(NULL), m_size(0) {}
+	~MappedFile() { close(); }
+	bool open(const char* path, std::string& error);
+	void close();
+	const char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const char* m_data;
+	size_t m_size;
+};
+
+//Checks the header and size of a binary system. rows points into the
+//mapping (8 byte aligned), with row i at rows + i * (m + 1).
+bool readBinarySystem(const MappedFile& file, size_t& n, size_t& m, const double*& rows, std::string& error);
+bool writeBinarySystem(const char* path, size_t n, size_t m, const double* rows, std::string& error);
+
+//Parses the text format from [begin, end) with std::from_chars, rows gets
+//the n * (m + 1) values.
+bool parseTextSystem(const char* begin, const char* end, size_t& n, size_t& m, std::vector<double>& rows, std::string& error);
+
+#endif
@@ -1,14 +1,103 @@
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 #include "system.h"
+#include "kernels.h"
 
 using namespace std;
 
-System::System(size_t n, size_t m, std::vector< std::vector<double> > matrix) 
+static const double EPS = 1e-9;
+
+//columns factored per panel; the panel's U rows (PANEL x TILE doubles)
+//are reused from L2 while every trailing row streams past them
+static const size_t PANEL = 64;
+//columns of the trailing matrix per tile, one tile row (2KB) stays in L1
+static const size_t TILE = 256;
+//trailing rows handed to a thread at a time, a multiple of 4 so the split
+//into 4-row kernel calls (and so the arithmetic) is the same for any number
+//of threads
+static const size_t ROW_GRAIN = 32;
+//refinement steps the mixed precision solve may take before giving up
+static const size_t MAX_REFINE = 30;
+
+static inline void kernelAxpy(const Kernels& k, double* y, const double* x, double c, size_t n)
+{
+	k.axpy(y, x, c, n);
+}
+
+static inline void kernelAxpy(const Kernels& k, float* y, const float* x, float c, size_t n)
+{
+	k.axpyf(y, x, c, n);
+}
+
+static inline void kernelRankUpdate(const Kernels& k, double* const* a, size_t nrows, const double* l, size_t r,
+	const double* u, size_t ustride, size_t w)
+{
+	k.rankUpdate(a, nrows, l, r, u, ustride, w);
+}
+
+static inline void kernelRankUpdate(const Kernels& k, float* const* a, size_t nrows, const float* l, size_t r,
+	const float* u, size_t ustride, size_t w)
+{
+	k.rankUpdatef(a, nrows, l, r, u, ustride, w);
+}
+
+System::System(size_t n, size_t m, const std::vector< std::vector<double> >& matrix)
+{
+	m_n = n;
+	m_m = m;
+	m_matrix.resize(n, m);
+	m_rhs.resize(n, 1);
+	for (size_t i = 0; i < n; ++i) {
+		copy(matrix[i].begin(), matrix[i].begin() + m, m_matrix[i]);
+		m_rhs[i][0] = matrix[i][m];
+	}
+	m_numsol = -1;
+	m_factored = false;
+	m_mixed = false;
+	m_precision = PRECISION_DOUBLE;
+	m_refineSteps = 0;
+	m_residual = -1;
+	m_isSparse = false;
+}
+
+System::System(size_t n, size_t m, const double* rows, size_t stride)
 {
 	m_n = n;
 	m_m = m;
-	m_matrix = matrix;
+	m_matrix.resize(n, m);
+	m_rhs.resize(n, 1);
+	for (size_t i = 0; i < n; ++i) {
+		const double* r = rows + i * stride;
+		copy(r, r + m, m_matrix[i]);
+		m_rhs[i][0] = r[m];
+	}
+	m_numsol = -1;
+	m_factored = false;
+	m_mixed = false;
+	m_precision = PRECISION_DOUBLE;
+	m_refineSteps = 0;
+	m_residual = -1;
+	m_isSparse = false;
+}
+
+System::System(const SparseMatrix& a, const std::vector<double>& b)
+{
+	m_n = a.rows;
+	m_m = a.cols;
+	m_sparse = a;
+	m_rhs.resize(m_n, 1);
+	for (size_t i = 0; i < m_n; ++i)
+		m_rhs[i][0] = b[i];
 	m_numsol = -1;
+	m_factored = false;
+	m_mixed = false;
+	m_precision = PRECISION_DOUBLE;
+	m_refineSteps = 0;
+	m_residual = -1;
+	m_isSparse = true;
+	m_sparseRank = 0;
 }
 
 int System::getNumSolutions() //0 = zero solutions, 1 = one solution, 2 = infinite
@@ -21,51 +110,482 @@ std::vector<double> System::getSolution() //if 1 or 2 above, get a solution
 	return m_sol;
 }
 
-//adapted from 
-//https://cp-algorithms.com/linear_algebra/linear-system-gauss.html
-void System::solve()
+void System::setNumThreads(size_t nthreads)
 {
-	const double EPS = 1e-9;
-	const int INF = 2; 
-	
-	int n = (int) m_matrix.size();
-	int m = (int) m_matrix[0].size() - 1;
-
-	vector<int> where (m, -1);
-	for (int col=0, row=0; col<m && row<n; ++col) {
-		int sel = row;
-		for (int i=row; i<n; ++i)
-			if (abs (m_matrix[i][col]) > abs (m_matrix[sel][col]))
+	if (nthreads == 0)
+		nthreads = max(1u, thread::hardware_concurrency());
+	if (nthreads == getNumThreads())
+		return;
+	if (nthreads == 1)
+		m_pool.reset();
+	else
+		m_pool = make_shared<ThreadPool>(nthreads);
+}
+
+size_t System::getNumThreads()
+{
+	return m_pool ? m_pool->size() : 1;
+}
+
+bool System::isFactored()
+{
+	return m_factored;
+}
+
+void System::setIterative(const IterativeOptions& opt)
+{
+	m_iterOpt = opt;
+}
+
+IterativeStats System::getIterativeStats()
+{
+	return m_iterStats;
+}
+
+void System::setMixedPrecision(bool on)
+{
+	m_mixed = on;
+}
+
+SolvePrecision System::getPrecisionUsed()
+{
+	return m_precision;
+}
+
+size_t System::getRefinementSteps()
+{
+	return m_refineSteps;
+}
+
+double System::getResidualNorm()
+{
+	return m_residual;
+}
+
+size_t System::getRank()
+{
+	return m_isSparse ? m_sparseRank : m_pivcols.size();
+}
+
+//Unblocked right-looking elimination of columns [k, kend) on the rows not
+//yet pivoted. Multipliers are stored in place below each pivot and only the
+//panel's own columns are updated; everything right of kend is left for
+//updateTrailing(). Columns with no usable pivot are skipped (free variables).
+template <typename T>
+void System::factorPanel(DenseMatrix<T>& a, size_t kbeg, size_t kend)
+{
+	const Kernels& k = activeKernels();
+	for (size_t col = kbeg; col < kend && m_pivcols.size() < m_n; ++col) {
+		size_t row = m_pivcols.size();
+		size_t sel = row;
+		for (size_t i = row; i < m_n; ++i)
+			if (fabs (a[i][col]) > fabs (a[sel][col]))
 				sel = i;
-		if (abs (m_matrix[sel][col]) < EPS)
+		if (fabs (a[sel][col]) < EPS)
 			continue;
-		for (int i=col; i<=m; ++i)
-			swap (m_matrix[sel][i], m_matrix[row][i]);
-		where[col] = row;
-
-		for (int i=0; i<n; ++i)
-			if (i != row) {
-				double c = m_matrix[i][col] / m_matrix[row][col];
-				for (int j=col; j<=m; ++j)
-					m_matrix[i][j] -= m_matrix[row][j] * c;
-			}
-		++row;
+		a.swapRows(sel, row);
+		swap(m_perm[sel], m_perm[row]);
+		m_where[col] = (int) row;
+		m_pivcols.push_back(col);
+
+		const T* prow = a[row];
+		T piv = prow[col];
+		for (size_t i = row + 1; i < m_n; ++i) {
+			T* r = a[i];
+			T l = r[col] / piv;
+			r[col] = l;
+			kernelAxpy(k, r + col + 1, prow + col + 1, l, kend - col - 1);
+		}
+	}
+}
+
+//A22 -= L21 * U12 for the trailing rows [ib, ie), one TILE-wide strip of
+//columns at a time. Rows never depend on each other here, so disjoint row
+//ranges can run on different threads.
+template <typename T>
+void System::updateTrailingRows(DenseMatrix<T>& a, size_t row0, size_t kend, const T* lpack, size_t ib, size_t ie)
+{
+	const Kernels& k = activeKernels();
+	size_t row = m_pivcols.size();
+	size_t r = row - row0;
+	size_t width = m_m;
+	for (size_t jb = kend; jb < width; jb += TILE) {
+		size_t w = min(TILE, width - jb);
+		for (size_t i = ib; i < ie; i += 4) {
+			size_t nrows = min((size_t) 4, ie - i);
+			T* ap[4];
+			for (size_t ii = 0; ii < nrows; ++ii)
+				ap[ii] = a[i + ii] + jb;
+			kernelRankUpdate(k, ap, nrows, &lpack[(i - row) * r], r, a[row0] + jb, a.stride(), w);
+		}
+	}
+}
+
+//Applies the panel whose pivot rows start at row0 to the columns
+//[kend, m): U12 = L11^-1 A12, then A22 -= L21 * U12 split
+//over the thread pool by blocks of rows.
+template <typename T>
+void System::updateTrailing(DenseMatrix<T>& a, size_t row0, size_t kend)
+{
+	size_t row = m_pivcols.size();
+	size_t r = row - row0;
+	size_t width = m_m;
+	if (r == 0 || kend >= width)
+		return;
+
+	const Kernels& k = activeKernels();
+	for (size_t p = 0; p < r; ++p) {
+		const T* u = a[row0 + p];
+		size_t pc = m_pivcols[row0 + p];
+		for (size_t q = p + 1; q < r; ++q) {
+			T* aq = a[row0 + q];
+			kernelAxpy(k, aq + kend, u + kend, aq[pc], width - kend);
+		}
+	}
+
+	//gather L21 so the inner loop reads multipliers contiguously
+	vector<T> lpack((m_n - row) * r);
+	for (size_t i = row; i < m_n; ++i)
+		for (size_t p = 0; p < r; ++p)
+			lpack[(i - row) * r + p] = a[i][m_pivcols[row0 + p]];
+
+	const T* l = lpack.data();
+	if (!m_pool) {
+		updateTrailingRows(a, row0, kend, l, row, m_n);
+		return;
+	}
+	m_pool->parallelFor(row, m_n, ROW_GRAIN, [&](size_t ib, size_t ie) {
+		updateTrailingRows(a, row0, kend, l, ib, ie);
+	});
+}
+
+//Blocked LU with partial pivoting of a (the coefficients, or a float copy
+//of them). Row exchanges are applied across the whole row and recorded in
+//m_perm; on return the pivot rows hold U and the multipliers of L sit
+//below the pivots.
+template <typename T>
+void System::factorLU(DenseMatrix<T>& a)
+{
+	m_where.assign(m_m, -1);
+	m_pivcols.clear();
+	m_perm.resize(m_n);
+	for (size_t i = 0; i < m_n; ++i)
+		m_perm[i] = i;
+	for (size_t k = 0; k < m_m && m_pivcols.size() < m_n; k += PANEL) {
+		size_t kend = min(k + PANEL, m_m);
+		size_t row0 = m_pivcols.size();
+		factorPanel(a, k, kend);
+		updateTrailing(a, row0, kend);
+	}
+}
+
+void System::factor()
+{
+	if (m_isSparse)
+		return;
+	factorLU(m_matrix);
+	m_factored = true;
+}
+
+//Forward and back substitution for the right-hand side columns [cb, ce).
+//b (already permuted) is overwritten with L^-1 b; y receives the values of
+//the pivot variables in pivot order. Each row update runs across all the
+//columns of the batch at once.
+void System::substitute(Matrix& b, Matrix& y, size_t cb, size_t ce)
+{
+	const Kernels& k = activeKernels();
+	size_t rank = m_pivcols.size();
+	size_t w = ce - cb;
+
+	//L is unit lower triangular in the pivot columns: row i takes
+	//contributions from the min(i, rank) pivot rows above it. Rows go four
+	//at a time through the rank update for the pivots above the whole
+	//block, then pick up the few inside the block one by one.
+	vector<double> l(4 * rank);
+	for (size_t i0 = 0; i0 < m_n && rank > 0; i0 += 4) {
+		size_t nb = min((size_t) 4, m_n - i0);
+		size_t r = min(i0, rank);
+		double* rows[4];
+		for (size_t ii = 0; ii < nb; ++ii) {
+			rows[ii] = b[i0 + ii] + cb;
+			for (size_t p = 0; p < r; ++p)
+				l[ii * r + p] = m_matrix[i0 + ii][m_pivcols[p]];
+		}
+		if (r > 0)
+			k.rankUpdate(rows, nb, l.data(), r, b[0] + cb, b.stride(), w);
+		for (size_t ii = 1; ii < nb; ++ii)
+			for (size_t p = r; p < min(i0 + ii, rank); ++p)
+				k.axpy(rows[ii], b[p] + cb, m_matrix[i0 + ii][m_pivcols[p]], w);
+	}
+
+	for (size_t p = rank; p-- > 0; ) {
+		const double* u = m_matrix[p];
+		size_t r = rank - p - 1;
+		for (size_t q = 0; q < r; ++q)
+			l[q] = u[m_pivcols[p + 1 + q]];
+		double* yp = y[p] + cb;
+		copy(b[p] + cb, b[p] + ce, yp);
+		if (r > 0)
+			k.rankUpdate(&yp, 1, l.data(), r, y[p + 1] + cb, y.stride(), w);
+		double piv = u[m_pivcols[p]];
+		for (size_t c = 0; c < w; ++c)
+			yp[c] /= piv;
 	}
+}
 
-	m_sol.assign (m, 0);
-	for (int i=0; i<m; ++i)
-		if (where[i] != -1)
-			m_sol[i] = m_matrix[where[i]][m] / m_matrix[where[i]][i];
-	for (int i=0; i<n; ++i) {
-		double sum = 0;
-		for (int j=0; j<m; ++j)
-			sum += m_sol[j] * m_matrix[i][j];
-		if (abs (sum - m_matrix[i][m]) > EPS)
-			{m_numsol = 0;return;}
+void System::solveBatch(const Matrix& rhs, Matrix& sol, std::vector<int>& numsol)
+{
+	const int INF = 2;
+
+	size_t nrhs = rhs.cols();
+	if (m_isSparse) {
+		sol.resize(m_m, nrhs);
+		numsol.assign(nrhs, 0);
+		vector<double> b(m_n), x;
+		for (size_t c = 0; c < nrhs; ++c) {
+			for (size_t i = 0; i < m_n; ++i)
+				b[i] = rhs[i][c];
+			numsol[c] = sparseSolve(m_sparse, b, x, m_sparseRank);
+			for (size_t j = 0; j < m_m; ++j)
+				sol[j][c] = numsol[c] == 0 ? 0.0 : x[j];
+		}
+		return;
 	}
 
-	for (int i=0; i<m; ++i)
-		if (where[i] == -1)
-			{m_numsol = INF;return;}
+	if (!m_factored)
+		factor();
+
+	size_t rank = m_pivcols.size();
+	Matrix b(m_n, nrhs);
+	for (size_t i = 0; i < m_n; ++i)
+		copy(rhs[m_perm[i]], rhs[m_perm[i]] + nrhs, b[i]);
+	Matrix y(max(rank, (size_t) 1), nrhs);
+
+	//right-hand sides are independent, so wide batches are split by column
+	if (m_pool)
+		m_pool->parallelFor(0, nrhs, TILE, [&](size_t cb, size_t ce) {
+			substitute(b, y, cb, ce);
+		});
+	else
+		substitute(b, y, 0, nrhs);
+
+	sol.resize(m_m, nrhs);
+	numsol.assign(nrhs, rank < m_m ? INF : 1);
+	//any leftover row 0 = b_i with b_i != 0 makes that system inconsistent
+	for (size_t i = rank; i < m_n; ++i)
+		for (size_t c = 0; c < nrhs; ++c)
+			if (fabs (b[i][c]) > EPS)
+				numsol[c] = 0;
+	//free variables are 0
+	for (size_t p = 0; p < rank; ++p)
+		for (size_t c = 0; c < nrhs; ++c)
+			sol[m_pivcols[p]][c] = numsol[c] == 0 ? 0.0 : y[p][c];
+}
+
+std::vector< std::vector<double> > System::solveBatch(const std::vector< std::vector<double> >& rhs, std::vector<int>& numsol)
+{
+	Matrix b(m_n, rhs.size()), x;
+	for (size_t c = 0; c < rhs.size(); ++c)
+		for (size_t i = 0; i < m_n; ++i)
+			b[i][c] = rhs[c][i];
+	solveBatch(b, x, numsol);
+	vector< vector<double> > sols(rhs.size(), vector<double>(m_m));
+	for (size_t c = 0; c < rhs.size(); ++c)
+		for (size_t j = 0; j < m_m; ++j)
+			sols[c][j] = x[j][c];
+	return sols;
+}
+
+//r = b - a x with a the unfactored coefficients, split over the pool by
+//rows; returns ||r||_2
+double System::residual(const Matrix& a, const std::vector<double>& x, std::vector<double>& r)
+{
+	r.resize(m_n);
+	auto rows = [&](size_t ib, size_t ie) {
+		for (size_t i = ib; i < ie; ++i) {
+			const double* ai = a[i];
+			double s = m_rhs[i][0];
+			for (size_t j = 0; j < m_m; ++j)
+				s -= ai[j] * x[j];
+			r[i] = s;
+		}
+	};
+	if (m_pool)
+		m_pool->parallelFor(0, m_n, ROW_GRAIN, rows);
+	else
+		rows(0, m_n);
+	double s = 0;
+	for (size_t i = 0; i < m_n; ++i)
+		s += r[i] * r[i];
+	return sqrt(s);
+}
+
+//x = (LU)^-1 b for a full rank square float factorization, accumulating in
+//double; with every column pivoted, pivot p sits in column p
+void System::luSolve(const DenseMatrix<float>& lu, const std::vector<double>& b, std::vector<double>& x)
+{
+	x.resize(m_n);
+	for (size_t i = 0; i < m_n; ++i) {
+		const float* li = lu[i];
+		double s = b[m_perm[i]];
+		for (size_t p = 0; p < i; ++p)
+			s -= li[p] * x[p];
+		x[i] = s;
+	}
+	for (size_t p = m_n; p-- > 0; ) {
+		const float* u = lu[p];
+		double s = x[p];
+		for (size_t q = p + 1; q < m_n; ++q)
+			s -= u[q] * x[q];
+		x[p] = s / u[p];
+	}
+}
+
+//Mixed precision solve: LU of a float copy, then x += (LU)^-1 (b - Ax)
+//with the residual in double until it is down to what double rounding
+//allows (the LAPACK dsgesv test ||r|| <= sqrt(n) ||x|| ||A|| eps, in the
+//infinity norm). Returns false, leaving m_matrix untouched, if the float
+//factorization loses rank or the residual stops halving.
+bool System::solveMixed()
+{
+	if (m_isSparse || m_factored || m_n != m_m || m_n == 0)
+		return false;
+
+	DenseMatrix<float> lu(m_n, m_m);
+	double anorm = 0;
+	for (size_t i = 0; i < m_n; ++i) {
+		const double* ai = m_matrix[i];
+		float* fi = lu[i];
+		double rowsum = 0;
+		for (size_t j = 0; j < m_m; ++j) {
+			fi[j] = (float) ai[j];
+			rowsum += fabs (ai[j]);
+		}
+		anorm = max(anorm, rowsum);
+	}
+	if (!isfinite((float) anorm))
+		return false; //out of float range
+	factorLU(lu);
+	if (m_pivcols.size() < m_n)
+		return false;
+
+	vector<double> b(m_n), x(m_n, 0.0), r, d;
+	for (size_t i = 0; i < m_n; ++i)
+		b[i] = m_rhs[i][0];
+	luSolve(lu, b, x);
+	double prev = HUGE_VAL;
+	for (m_refineSteps = 0; ; ++m_refineSteps) {
+		m_residual = residual(m_matrix, x, r);
+		double rmax = 0, xmax = 0;
+		for (size_t i = 0; i < m_n; ++i) {
+			rmax = max(rmax, fabs (r[i]));
+			xmax = max(xmax, fabs (x[i]));
+		}
+		if (!isfinite(rmax) || m_refineSteps == MAX_REFINE || rmax > 0.5 * prev)
+			return false;
+		if (rmax <= sqrt((double) m_n) * xmax * anorm * numeric_limits<double>::epsilon())
+			break;
+		prev = rmax;
+		luSolve(lu, r, d);
+		for (size_t i = 0; i < m_n; ++i)
+			x[i] += d[i];
+	}
 	m_numsol = 1;
+	m_sol = x;
+	return true;
+}
+
+//true if some row or column of the square coefficient matrix is all zeros,
+//a rank deficiency found in one pass over the nonzeros
+bool System::hasEmptyLine()
+{
+	vector<char> used(m_m, 0);
+	for (size_t i = 0; i < m_n; ++i) {
+		bool empty = true;
+		if (m_isSparse) {
+			empty = m_sparse.rowptr[i] == m_sparse.rowptr[i + 1];
+			for (size_t t = m_sparse.rowptr[i]; t < m_sparse.rowptr[i + 1]; ++t)
+				used[m_sparse.colind[t]] = 1;
+		} else {
+			for (size_t j = 0; j < m_m; ++j)
+				if (m_matrix[i][j] != 0.0) {
+					used[j] = 1;
+					empty = false;
+				}
+		}
+		if (empty)
+			return true;
+	}
+	return find(used.begin(), used.end(), 0) != used.end();
+}
+
+//adapted from
+//https://cp-algorithms.com/linear_algebra/linear-system-gauss.html
+//
+//The elimination is done as a blocked LU factorization followed by
+//forward/back substitution instead of Gauss-Jordan, free variables are
+//still set to 0.
+void System::solve()
+{
+	m_iterStats = IterativeStats();
+	m_precision = PRECISION_DOUBLE;
+	m_refineSteps = 0;
+	m_residual = -1;
+	vector<double> b(m_n);
+	double bnorm = 0;
+	for (size_t i = 0; i < m_n; ++i) {
+		b[i] = m_rhs[i][0];
+		bnorm += b[i] * b[i];
+	}
+	//a dense matrix is multiplied in place, so only until factor() overwrites it
+	if (m_iterOpt.method != SOLVE_DIRECT && m_n == m_m && bnorm != 0.0 && (m_isSparse || !m_factored)) {
+		vector<double> x;
+		if (m_isSparse)
+			m_iterStats = iterativeSolve(m_sparse, b, x, m_iterOpt, m_pool.get());
+		else
+			m_iterStats = iterativeSolve(m_matrix, b, x, m_iterOpt, m_pool.get());
+		if (m_iterStats.converged) {
+			//b != 0 is reached, so there is a solution; a small residual
+			//doesn't show the rank (x+y=2 twice), only the structural check
+			//or, when asked for, elimination does
+			m_numsol = hasEmptyLine() ? 2 : 1;
+			if (m_iterOpt.classify) {
+				Matrix xd;
+				vector<int> numsol;
+				solveBatch(m_rhs, xd, numsol);
+				m_numsol = numsol[0];
+				if (m_numsol == 0) {
+					m_sol.assign(m_m, 0);
+					return;
+				}
+			}
+			m_sol = x;
+			m_residual = m_iterStats.residuals.back() * sqrt(bnorm);
+			return;
+		}
+		m_iterStats.fellBack = true;
+	}
+
+	Matrix a;
+	if (m_mixed) {
+		if (solveMixed()) {
+			m_precision = PRECISION_MIXED;
+			return;
+		}
+		//keep A around to report the residual of the double solve
+		if (!m_isSparse && !m_factored)
+			a = m_matrix;
+	}
+
+	Matrix x;
+	vector<int> numsol;
+	solveBatch(m_rhs, x, numsol);
+	m_numsol = numsol[0];
+	m_sol.assign(m_m, 0);
+	for (size_t j = 0; j < m_m; ++j)
+		m_sol[j] = x[j][0];
+	if (a.rows() == m_n && m_n > 0) {
+		vector<double> r;
+		m_residual = residual(a, m_sol, r);
+	}
 }
@@ -1,19 +1,102 @@
 #ifndef __SYSTEM_H__
 #define __SYSTEM_H__
 #include <vector>
+#include <memory>
+#include "matrix.h"
+#include "threadpool.h"
+#include "sparse.h"
+#include "iterative.h"
+
+enum SolvePrecision {
+	PRECISION_DOUBLE, //LU in double (or the sparse / iterative solvers)
+	PRECISION_MIXED   //LU in float plus iterative refinement in double
+};
 
 class System {
 public:
-	System(size_t n, size_t m, std::vector< std::vector<double> > matrix);
+	System(size_t n, size_t m, const std::vector< std::vector<double> >& matrix);
+	//row i of the augmented matrix (m coefficients then b) starts at
+	//rows + i * stride, e.g. straight out of a mapped file
+	System(size_t n, size_t m, const double* rows, size_t stride);
+	//a is n x m, b has length n; solve() then runs sparseSolve() and the
+	//dense matrix is never allocated
+	System(const SparseMatrix& a, const std::vector<double>& b);
 	void solve();
 	int getNumSolutions(); //0 = zero solutions, 1 = one solution, 2 = infinite
 	std::vector<double> getSolution(); //if 1 or 2 above, get a solution
+	void setNumThreads(size_t nthreads); //threads used by solve(), 0 = all cores
+	size_t getNumThreads();
+
+	//Factors the coefficient matrix once, keeping the row permutation, the
+	//pivot columns and the rank. solve() and solveBatch() factor on first
+	//use and reuse the factorization after that. Sparse systems are not
+	//factored ahead of time, solveBatch() runs one sparse solve per column.
+	void factor();
+	bool isFactored();
+	size_t getRank();
+	//rhs is n x k with one right-hand side per column. sol is resized to
+	//m x k and numsol to k, numsol[c] classifies column c like
+	//getNumSolutions() (columns with no solution come back as zeros).
+	void solveBatch(const Matrix& rhs, Matrix& sol, std::vector<int>& numsol);
+	//same, with each inner vector one b (length n) / one solution (length m)
+	std::vector< std::vector<double> > solveBatch(const std::vector< std::vector<double> >& rhs, std::vector<int>& numsol);
+
+	//With opt.method other than SOLVE_DIRECT, solve() on a square system
+	//with b != 0 runs that Krylov method instead of elimination and, once it
+	//converges, returns its x. Convergence shows a solution exists but not
+	//that A is nonsingular: getNumSolutions() is 2 if A has an empty row or
+	//column and 1 otherwise, unless opt.classify asks for the count from a
+	//factorization (which costs as much as the direct solve). b = 0 goes to
+	//the direct solver, there only the rank decides. If the method does not
+	//converge, the direct solver runs and getIterativeStats().fellBack is
+	//set. A dense A is used in place (ILU(0) becomes Jacobi), so once it has
+	//been factored every later solve() is direct. solveBatch() is always
+	//direct.
+	void setIterative(const IterativeOptions& opt);
+	IterativeStats getIterativeStats();
+
+	//With mixed precision on, solve() on a square dense system factors a
+	//float copy of the coefficients (twice the SIMD width, half the memory
+	//traffic) and refines that solution with residuals computed in double
+	//until it is accurate to double precision. If the float factorization is
+	//singular or refinement stalls, the double solver runs instead.
+	void setMixedPrecision(bool on);
+	SolvePrecision getPrecisionUsed(); //how the last solve() got its answer
+	size_t getRefinementSteps(); //taken by the last mixed attempt, even one that fell back
+	//||b - Ax||_2 of the last solve(), -1 after a plain double LU solve
+	//(the factorization overwrites A, so nothing is left to check against)
+	double getResidualNorm();
 	
 private:
+	template <typename T> void factorLU(DenseMatrix<T>& a);
+	template <typename T> void factorPanel(DenseMatrix<T>& a, size_t kbeg, size_t kend);
+	template <typename T> void updateTrailing(DenseMatrix<T>& a, size_t row0, size_t kend);
+	template <typename T> void updateTrailingRows(DenseMatrix<T>& a, size_t row0, size_t kend, const T* lpack, size_t ib, size_t ie);
+	void substitute(Matrix& b, Matrix& y, size_t cb, size_t ce);
+	bool solveMixed();
+	void luSolve(const DenseMatrix<float>& lu, const std::vector<double>& b, std::vector<double>& x);
+	double residual(const Matrix& a, const std::vector<double>& x, std::vector<double>& r);
+	bool hasEmptyLine();
+
 	size_t m_n, m_m;
 	int m_numsol;
-	std::vector<std::vector<double> > m_matrix;
+	Matrix m_matrix; //n x m coefficients, overwritten with L\U by factor()
+	Matrix m_rhs; //n x 1, the b column of the augmented matrix
+	bool m_isSparse;
+	SparseMatrix m_sparse; //coefficients of a sparse system, m_matrix is empty then
+	size_t m_sparseRank;
+	IterativeOptions m_iterOpt;
+	IterativeStats m_iterStats;
+	bool m_mixed;
+	SolvePrecision m_precision;
+	size_t m_refineSteps;
+	double m_residual;
+	bool m_factored;
+	std::vector<size_t> m_perm; //original index of each row after pivoting
+	std::vector<int> m_where; //pivot row of each column, -1 if free
+	std::vector<size_t> m_pivcols; //pivot column of each pivot row
 	std::vector<double> m_sol;
+	std::shared_ptr<ThreadPool> m_pool; //null when running on one thread
 };
 
 #endif
\ No newline at end of file